@@ -19,6 +19,7 @@
 */
 
 #include <stdio.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdlib.h>
 
@@ -27,7 +28,6 @@
 #include "epicsVersion.h"
 #ifdef BASE_VERSION
 #define EPICS_3_13
-int epicsStrGlobMatch(const char *str, const char *pattern);
 #define epicsMutexMustLock(lock) FASTLOCK(&lock)
 #define epicsMutexUnlock(lock)   FASTUNLOCK(&lock)
 #define CA_MAJOR_PROTOCOL_REVISION CA_PROTOCOL_VERSION
@@ -43,11 +43,58 @@ struct dbFldDes{
 #include "dbBase.h"
 #include "dbCommon.h"
 #include "iocsh.h"
+#include "epicsTime.h"
+#include "epicsThread.h"
+#include "epicsMutex.h"
+#include "gpHash.h"
+#include "asTrapWrite.h"
+#include "epicsEvent.h"
+#include "errlog.h"
+#include "dbAccess.h"
+#include "dbLock.h"
+#include "dbNotify.h"
+#include "dbEvent.h"
 #include "epicsStdioRedirect.h"
 #include "server.h"
 #include "epicsExport.h"
 #endif
 
+#include "globMatch.h"
+#ifndef EPICS_3_13
+#include "threads.h"
+#endif
+
+#if EPICS_VERSION*10000+EPICS_REVISION*100+EPICS_MODIFICATION > 31500
+#include "dbChannel.h"
+#define CAL_EVENT_STATS
+#endif
+
+#if EPICS_VERSION*10000+EPICS_REVISION*100+EPICS_MODIFICATION > 31500
+#define CAL_THREAD_HOOKS
+#endif
+
+#if defined(__unix__) && !defined(__rtems__) && !defined(EPICS_3_13)
+#include <unistd.h>
+#include <termios.h>
+#include <sys/select.h>
+#include <sys/ioctl.h>
+#define CAL_TOP
+#endif
+
+#if defined(__linux__) && !defined(EPICS_3_13)
+#include <stdint.h>
+#include <sys/ioctl.h>
+#include <netinet/tcp.h>
+#ifdef TCP_INFO
+#define CAL_TCP_INFO
+#endif
+#endif
+
+#if !defined(EPICS_3_13) && EPICS_VERSION*10000+EPICS_REVISION*100+EPICS_MODIFICATION < 31600
+/* the UDP server is not in clientQ */
+#define CAL_CAST_CLIENT
+#endif
+
 #if EPICS_VERSION*10000+EPICS_REVISION*100+EPICS_MODIFICATION < 31412
 #define chanListLock addrqLock
 #define chanList     addrq
@@ -60,119 +107,2713 @@ struct dbFldDes{
 #endif
 
 int calDebug = 0;
+int calWatchReportPeriod = 60;
 #ifndef EPICS_3_13
 epicsExportAddress(int, calDebug);
+epicsExportAddress(int, calWatchReportPeriod);
 #endif
 
-long cal(const char* match, int level)
-{
 #ifndef _WIN32
-    struct client *client;
-    int matchfield;
+/*
+    Snapshot of all clients and channels.
+    The rsrv locks are only held while copying the data, formatting and
+    printing (which may block on a slow console) is done afterwards.
+    Record and field names are static and can be referenced, everything
+    that belongs to a client may disappear after the locks are released
+    and is copied.
+*/
+
 #define MAX_FIELD_NAME_LENGTH 10
-    char fullname[PVNAME_STRINGSZ+MAX_FIELD_NAME_LENGTH+1];
+#define CAL_HOSTNAME_LENGTH 256
+
+#ifdef CAL_TCP_INFO
+/* Copy of the Linux struct tcp_info, which is only appended to in newer
+   kernels. The C library header may be older than the running kernel,
+   thus use our own and check how much the kernel has filled in. */
+struct calTcpInfo {
+    unsigned char state, ca_state, retransmits, probes, backoff, options, wscale, flags;
+    unsigned int rto, ato, snd_mss, rcv_mss;
+    unsigned int unacked, sacked, lost, retrans, fackets;
+    unsigned int last_data_sent, last_ack_sent, last_data_recv, last_ack_recv;
+    unsigned int pmtu, rcv_ssthresh, rtt, rttvar, snd_ssthresh, snd_cwnd, advmss, reordering;
+    unsigned int rcv_rtt, rcv_space;
+    unsigned int total_retrans;
+    uint64_t pacing_rate, max_pacing_rate;
+    uint64_t bytes_acked, bytes_received;
+    unsigned int segs_out, segs_in;
+    unsigned int notsent_bytes, min_rtt, data_segs_in, data_segs_out;
+    uint64_t delivery_rate;
+    uint64_t busy_time, rwnd_limited, sndbuf_limited;
+    unsigned int delivered, delivered_ce;
+    uint64_t bytes_sent, bytes_retrans;
+    unsigned int dsack_dups, reord_seen, rcv_ooopack, snd_wnd;
+};
+
+#define calTcpHas(c, field) ((c)->tcpInfoSize >= offsetof(struct calTcpInfo, field) + sizeof((c)->tcpInfo.field))
+#endif
+
+struct calClient {
+    void *id;                       /* struct client pointer, only used as key */
+    void *tid;
+    unsigned int lwpId;
+    unsigned int minor_version_number;
+    int proto;
+    struct sockaddr_in addr;
+    char user[40];
+    char host[CAL_HOSTNAME_LENGTH];
+    int hasUser;
+    int hasHost;
     char clientref[100];
+    /* only filled in for statistics */
+    unsigned long nchannels;
+    unsigned long nmonitors;
+    unsigned long queued;           /* events currently in the queue */
+    unsigned long replaced;         /* events replaced in the queue (total) */
+    unsigned long puts;             /* TRAPWRITE puts of user@host (total) */
+#ifndef EPICS_3_13
+    /* carried over between samples by calWatch */
+    unsigned int growing;           /* number of samples with growing queue */
+    int reported;
+    epicsTimeStamp lastReport;
+#endif
+#ifdef CAL_TCP_INFO
+    size_t tcpInfoSize;             /* 0 if not available */
+    struct calTcpInfo tcpInfo;
+    int sendQueue;                  /* bytes in socket send queue or -1 */
+#endif
+};
 
-    if (match && !*match) match= NULL;
-    matchfield = match && strchr(match, '.');
+struct calChannel {
+    size_t client;                  /* index into clients */
+    const void *pciu;               /* only used as key */
+    struct dbCommon *precord;
+    const char *recname;
+    const char *fieldname;
+    int state;
+    char access;                    /* 'w', 'r' or 'n' */
+    char monitor;
+    unsigned int nmonitors;
+    char putNotify;
+    /* only filled in for statistics */
+    unsigned int mask;              /* DBE_* of all monitors */
+    unsigned long eventSize;        /* bytes sent per event for all monitors */
+    unsigned long maxEventSize;
+};
+
+struct calSnapshot {
+    struct calClient *clients;
+    size_t nclients;
+    struct calChannel *channels;
+    size_t nchannels;
+    double lockTime;                /* seconds clientQ lock was held */
+    double maxChanLockTime;         /* longest chanListLock hold of one client */
+};
+
+static void calCopyString(char *dest, size_t size, const char *src)
+{
+    strncpy(dest, src, size - 1);
+    dest[size - 1] = 0;
+}
+
+static void calSnapshotFree(struct calSnapshot *snap)
+{
+    free(snap->clients);
+    free(snap->channels);
+    memset(snap, 0, sizeof(*snap));
+}
+
+#ifndef EPICS_3_13
+/* per client counters, called with the chanListLock held */
+static void calClientStats(struct client *client, struct calClient *c)
+{
+    struct channel_in_use *pciu;
+
+    epicsMutexMustLock(client->eventqLock);
+    for (pciu = (struct channel_in_use *) ellFirst(&client->chanList); pciu;
+                            pciu = (struct channel_in_use *)ellNext(&pciu->node))
+    {
+#ifdef CAL_EVENT_STATS
+        struct event_ext *pevext;
+
+        for (pevext = (struct event_ext *) ellFirst(&pciu->eventq); pevext;
+                                pevext = (struct event_ext *)ellNext(&pevext->node))
+        {
+            if (!pevext->pdbev) continue;
+            c->queued += pevext->pdbev->npend;
+            c->replaced += pevext->pdbev->nreplace;
+        }
+#endif
+        c->nchannels++;
+        c->nmonitors += ellCount(&pciu->eventq);
+    }
+    epicsMutexUnlock(client->eventqLock);
+#ifdef CAL_TCP_INFO
+    if (client->proto == IPPROTO_TCP)
+    {
+        socklen_t len = sizeof(c->tcpInfo);
+        if (getsockopt(client->sock, IPPROTO_TCP, TCP_INFO, &c->tcpInfo, &len) == 0)
+            c->tcpInfoSize = len;
+        c->sendQueue = -1;
+#ifdef TIOCOUTQ
+        if (ioctl(client->sock, TIOCOUTQ, &c->sendQueue) != 0)
+            c->sendQueue = -1;
+#endif
+    }
+#endif
+}
+#endif
+
+#ifndef EPICS_3_13
+/* payload of all monitors of a channel, called with the eventqLock held */
+static void calChannelEvents(struct channel_in_use *pciu, struct calChannel *ch)
+{
+    struct event_ext *pevext;
+
+    for (pevext = (struct event_ext *) ellFirst(&pciu->eventq); pevext;
+                            pevext = (struct event_ext *)ellNext(&pevext->node))
+    {
+        /* padded to 8 bytes, large arrays use the extended header */
+        unsigned long size = ((pevext->size + 7) & ~7ul) + sizeof(caHdr);
+        if (size >= 0xffff) size += 8;
+        ch->mask |= pevext->mask;
+        ch->eventSize += size;
+        if (size > ch->maxEventSize) ch->maxEventSize = size;
+    }
+}
+#endif
+
+/* returns 1 if the buffers were too small */
+static int calSnapshotFill(struct calSnapshot *snap, size_t maxClients, size_t maxChannels, int stats)
+{
+    struct client *client;
+#ifndef EPICS_3_13
+    epicsTimeStamp lockStart, chanStart, now;
+#endif
 
     LOCK_CLIENTQ
+#ifndef EPICS_3_13
+    epicsTimeGetCurrent(&lockStart);
+#endif
     for (client = (struct client *)ellNext(&clientQ.node); client; client = (struct client *)ellNext(&client->node))
     {
+        struct calClient *c;
         struct channel_in_use *pciu;
-        int n = 0;
-        if (calDebug) fprintf(stderr, "host: %s\nuser: %s\n", client->pHostName, client->pUserName);
-        if (level >= 4) {
-            n += sprintf(clientref + n, "TID %p ", (void*)client->tid);
+
+        if (snap->nclients == maxClients) break;
+        c = &snap->clients[snap->nclients];
+        c->id = client;
+        c->tid = (void*)client->tid;
 #if defined(linux) && defined(EPICS_VERSION_INT)
-            n += sprintf(clientref + n, "(PID %u) ", client->tid->lwpId);
+        c->lwpId = client->tid ? client->tid->lwpId : 0;
 #endif
-        }
-        if (level >= 2) {
-            n += sprintf(clientref + n, "V%u.%u %s:",
-                CA_MAJOR_PROTOCOL_REVISION,
-                client->minor_version_number,
-                client->proto == IPPROTO_UDP ? "UDP" :
-                client->proto == IPPROTO_TCP ? "TCP" : "UKN");
-        }
-        n += sprintf(clientref + n, "%.36s@", client->pUserName ? client->pUserName : "?");
-        if (client->pHostName)
-        {
-            sprintf(clientref + n, "%.*s:%i",
-                (int)strcspn(client->pHostName, "."),
-                client->pHostName, ntohs(client->addr.sin_port));
-        }
-        else
+        c->minor_version_number = client->minor_version_number;
+        c->proto = client->proto;
+        c->addr = client->addr;
+        c->hasUser = client->pUserName != NULL;
+        if (c->hasUser) calCopyString(c->user, sizeof(c->user), client->pUserName);
+        c->hasHost = client->pHostName != NULL;
+        if (c->hasHost) calCopyString(c->host, sizeof(c->host), client->pHostName);
+
+        epicsMutexMustLock(client->chanListLock);
+#ifndef EPICS_3_13
+        epicsTimeGetCurrent(&chanStart);
+        if (stats)
         {
-            ipAddrToA(&client->addr, clientref + n, sizeof(clientref) - n);
-            if (clientref[n] > '9')
-                sprintf(clientref + n + strcspn(clientref + n, "."), ":%i",
-                    ntohs(client->addr.sin_port));
+            calClientStats(client, c);
+            epicsMutexMustLock(client->eventqLock);
         }
-        if (calDebug) fprintf(stderr, "clientref: %s\n", clientref);
-        epicsMutexMustLock(client->chanListLock);
+#endif
         for (pciu = (struct channel_in_use *) ellFirst(&client->chanList); pciu;
                                 pciu = (struct channel_in_use *)ellNext(&pciu->node))
         {
-            const char* recname = getAddr(pciu).precord->name;
-            if (calDebug) fprintf(stderr, "channel: %s\n", recname);
-            if (!recname) continue;
-            sprintf(fullname, "%.*s.%.*s",
-                PVNAME_STRINGSZ, recname,
-                MAX_FIELD_NAME_LENGTH, ((struct dbFldDes*)getAddr(pciu).pfldDes)->name);
-            if (calDebug) fprintf(stderr, "fullname: %s\n", fullname);
-            if (!match || epicsStrGlobMatch(matchfield ? fullname : recname, match)
-                || (client->pUserName && epicsStrGlobMatch(client->pUserName, match))
-                || (client->pHostName && epicsStrGlobMatch(client->pHostName, match))
-                || epicsStrGlobMatch(clientref, match))
-            {
-                printf("%s%s %s%s%s==> %s\n",
+            struct calChannel *ch;
+
+            if (snap->nchannels == maxChannels) break;
+            ch = &snap->channels[snap->nchannels++];
+            ch->client = snap->nclients;
+            ch->pciu = pciu;
+            ch->precord = getAddr(pciu).precord;
+            ch->recname = ch->precord->name;
+            ch->fieldname = ((struct dbFldDes*)getAddr(pciu).pfldDes)->name;
 #ifndef EPICS_3_13
-                    level < 3 ? "" :
-                        pciu->state == rsrvCS_invalid ? "[invalid]" :
-                        pciu->state == rsrvCS_pendConnectResp ? "[connect]" :
-                        pciu->state == rsrvCS_inService ? "[active]" :
-                        pciu->state == rsrvCS_pendConnectRespUpdatePendAR ? "[connectAR]" :
-                        pciu->state == rsrvCS_inServiceUpdatePendAR ? "[activeAR]" :
-                        pciu->state == rsrvCS_shutdown ? "[shutdown]" : "[unknown]",
-#else
-                    "",
-#endif
-                    clientref,
-                    level < 1 ? "" :
-                        asCheckPut(pciu->asClientPVT) ?
-                            pciu->asClientPVT->trapMask ? "w" : "w" :
-                        asCheckGet(pciu->asClientPVT) ? "r" : "n",
-                    level < 1 ? "" :
-                            ellCount(&pciu->eventq) ? "m" : "",
-                    level < 1 ? "" :
-                            pciu->pPutNotify ? "p" : "",
-                    fullname
-                );
-            }
+            ch->state = pciu->state;
+#endif
+            ch->access = asCheckPut(pciu->asClientPVT) ? 'w' :
+                asCheckGet(pciu->asClientPVT) ? 'r' : 'n';
+            ch->nmonitors = ellCount(&pciu->eventq);
+            ch->monitor = ch->nmonitors != 0;
+            ch->putNotify = pciu->pPutNotify != NULL;
+#ifndef EPICS_3_13
+            if (stats) calChannelEvents(pciu, ch);
+#endif
         }
+#ifndef EPICS_3_13
+        if (stats) epicsMutexUnlock(client->eventqLock);
+        epicsTimeGetCurrent(&now);
+        if (epicsTimeDiffInSeconds(&now, &chanStart) > snap->maxChanLockTime)
+            snap->maxChanLockTime = epicsTimeDiffInSeconds(&now, &chanStart);
+#endif
         epicsMutexUnlock(client->chanListLock);
+        snap->nclients++;
+        if (pciu) break;
     }
+#ifndef EPICS_3_13
+    epicsTimeGetCurrent(&now);
+    snap->lockTime = epicsTimeDiffInSeconds(&now, &lockStart);
+#endif
     UNLOCK_CLIENTQ
+    return client != NULL;
+}
+
+static int calSnapshotTake(struct calSnapshot *snap, int stats)
+{
+    struct client *client;
+    size_t maxClients, maxChannels;
+
+    memset(snap, 0, sizeof(*snap));
+
+    /* estimate size, channel counts are read without the channel locks */
+    maxClients = maxChannels = 0;
+    LOCK_CLIENTQ
+    maxClients = ellCount(&clientQ);
+    for (client = (struct client *)ellNext(&clientQ.node); client; client = (struct client *)ellNext(&client->node))
+        maxChannels += ellCount(&client->chanList);
+    UNLOCK_CLIENTQ
+
+    while (1)
+    {
+        /* leave room for clients connecting in the meantime */
+        maxClients += maxClients / 4 + 16;
+        maxChannels += maxChannels / 4 + 256;
+        snap->clients = calloc(maxClients, sizeof(struct calClient));
+        snap->channels = calloc(maxChannels, sizeof(struct calChannel));
+        if (!snap->clients || !snap->channels)
+        {
+            fprintf(stderr, "cal: out of memory\n");
+            calSnapshotFree(snap);
+            return -1;
+        }
+        if (!calSnapshotFill(snap, maxClients, maxChannels, stats)) return 0;
+        calSnapshotFree(snap);
+    }
+}
+
+static void calClientRef(struct calClient *c, int level)
+{
+    char *clientref = c->clientref;
+    int n = 0;
+
+    if (level >= 4) {
+        n += sprintf(clientref + n, "TID %p ", c->tid);
+#if defined(linux) && defined(EPICS_VERSION_INT)
+        n += sprintf(clientref + n, "(PID %u) ", c->lwpId);
 #endif
-    return 0;
+    }
+    if (level >= 2) {
+        n += sprintf(clientref + n, "V%u.%u %s:",
+            CA_MAJOR_PROTOCOL_REVISION,
+            c->minor_version_number,
+            c->proto == IPPROTO_UDP ? "UDP" :
+            c->proto == IPPROTO_TCP ? "TCP" : "UKN");
+    }
+    n += sprintf(clientref + n, "%.36s@", c->hasUser ? c->user : "?");
+    if (c->hasHost)
+    {
+        sprintf(clientref + n, "%.*s:%i",
+            (int)strcspn(c->host, "."),
+            c->host, ntohs(c->addr.sin_port));
+    }
+    else
+    {
+        ipAddrToA(&c->addr, clientref + n, sizeof(c->clientref) - n);
+        if (clientref[n] > '9')
+            sprintf(clientref + n + strcspn(clientref + n, "."), ":%i",
+                ntohs(c->addr.sin_port));
+    }
 }
+#endif
+
+long cal(const char* match, int level)
+{
+#ifndef _WIN32
+    struct calSnapshot snap;
+    int matchfield;
+    char fullname[PVNAME_STRINGSZ+MAX_FIELD_NAME_LENGTH+1];
+    globMatcher *matcher;
+    size_t i;
+
+    if (match && !*match) match= NULL;
+    matchfield = match && strchr(match, '.');
+
+    if (calSnapshotTake(&snap, 0) != 0) return -1;
+    matcher = globCompile(match);
+
+    for (i = 0; i < snap.nclients; i++)
+    {
+        struct calClient *c = &snap.clients[i];
+        if (calDebug) fprintf(stderr, "host: %s\nuser: %s\n",
+            c->hasHost ? c->host : "(null)", c->hasUser ? c->user : "(null)");
+        calClientRef(c, level);
+        if (calDebug) fprintf(stderr, "clientref: %s\n", c->clientref);
+    }
+    for (i = 0; i < snap.nchannels; i++)
+    {
+        struct calChannel *ch = &snap.channels[i];
+        struct calClient *c = &snap.clients[ch->client];
+        const char* recname = ch->recname;
 
+        if (calDebug) fprintf(stderr, "channel: %s\n", recname);
+        if (!recname) continue;
+        sprintf(fullname, "%.*s.%.*s",
+            PVNAME_STRINGSZ, recname,
+            MAX_FIELD_NAME_LENGTH, ch->fieldname);
+        if (calDebug) fprintf(stderr, "fullname: %s\n", fullname);
+        if (!match || globMatch(matcher, matchfield ? fullname : recname)
+            || (c->hasUser && globMatch(matcher, c->user))
+            || (c->hasHost && globMatch(matcher, c->host))
+            || globMatch(matcher, c->clientref))
+        {
+            printf("%s%s %s%s%s==> %s\n",
 #ifndef EPICS_3_13
-static const iocshFuncDef calDef =
-    { "cal", 2, (const iocshArg *[]) {
-    &(iocshArg) { "record name pattern", iocshArgString },
-    &(iocshArg) { "level", iocshArgInt },
-}};
+                level < 3 ? "" :
+                    ch->state == rsrvCS_invalid ? "[invalid]" :
+                    ch->state == rsrvCS_pendConnectResp ? "[connect]" :
+                    ch->state == rsrvCS_inService ? "[active]" :
+                    ch->state == rsrvCS_pendConnectRespUpdatePendAR ? "[connectAR]" :
+                    ch->state == rsrvCS_inServiceUpdatePendAR ? "[activeAR]" :
+                    ch->state == rsrvCS_shutdown ? "[shutdown]" : "[unknown]",
+#else
+                "",
+#endif
+                c->clientref,
+                level < 1 ? "" :
+                    ch->access == 'w' ? "w" : ch->access == 'r' ? "r" : "n",
+                level < 1 ? "" :
+                    ch->monitor ? "m" : "",
+                level < 1 ? "" :
+                    ch->putNotify ? "p" : "",
+                fullname
+            );
+        }
+    }
+#ifndef EPICS_3_13
+    if (level >= 5)
+        printf("%lu clients, %lu channels, lock held %.1f us (longest client channel list %.1f us)\n",
+            (unsigned long)snap.nclients, (unsigned long)snap.nchannels,
+            snap.lockTime * 1e6, snap.maxChanLockTime * 1e6);
+#endif
+    calSnapshotFree(&snap);
+    globFree(matcher);
+#endif
+    return 0;
+}
 
-void calFunc(const iocshArgBuf *args)
+#if !defined(_WIN32) && !defined(EPICS_3_13)
+/*
+    Puts are not counted by the CA server. An asTrapWrite listener sees
+    puts to fields with a TRAPWRITE access security rule, together with
+    user and host of the client. Clients are matched by user@host.
+    Puts to fields without TRAPWRITE rule are not seen.
+    Posted events are not counted either: struct evSubscrip only has the
+    number of events currently queued (npend) and the total number of
+    replaced events (nreplace), there is no total of posted events and
+    no hook to count them.
+*/
+
+struct calPutCounter {
+    unsigned long count;
+    char key[1];
+};
+
+static epicsMutexId calPutLock;
+static struct gphPvt *calPutHash;
+static epicsThreadOnceId calPutOnce = EPICS_THREAD_ONCE_INIT;
+
+static void calPutKey(char *key, const char *user, const char *host)
 {
-    cal(args[0].sval, args[1].ival);
+    sprintf(key, "%.39s@%.255s", user ? user : "", host ? host : "");
 }
 
-static void calRegistrar(void)
+static void calTrapWriteListener(asTrapWriteMessage *pmessage, int after)
 {
-    iocshRegister(&calDef, calFunc);
+    char key[300];
+    GPHENTRY *pgph;
+    struct calPutCounter *counter;
+
+    if (!after) return;
+    calPutKey(key, pmessage->userid, pmessage->hostid);
+    epicsMutexMustLock(calPutLock);
+    pgph = gphFind(calPutHash, key, &calPutHash);
+    if (!pgph)
+    {
+        counter = malloc(sizeof(struct calPutCounter) + strlen(key));
+        if (counter)
+        {
+            strcpy(counter->key, key);
+            counter->count = 0;
+            pgph = gphAdd(calPutHash, counter->key, &calPutHash);
+            if (pgph) pgph->userPvt = counter;
+            else free(counter);
+        }
+    }
+    if (pgph) ((struct calPutCounter *)pgph->userPvt)->count++;
+    epicsMutexUnlock(calPutLock);
+}
+
+static unsigned long calPutCount(const struct calClient *c)
+{
+    char key[300];
+    GPHENTRY *pgph;
+    unsigned long count = 0;
+
+    calPutKey(key, c->hasUser ? c->user : NULL, c->hasHost ? c->host : NULL);
+    epicsMutexMustLock(calPutLock);
+    pgph = gphFind(calPutHash, key, &calPutHash);
+    if (pgph) count = ((struct calPutCounter *)pgph->userPvt)->count;
+    epicsMutexUnlock(calPutLock);
+    return count;
+}
+
+enum { CAL_CHAN, CAL_MON, CAL_QUEUE, CAL_REPL, CAL_OUT, CAL_IN, CAL_PUT, CAL_NCOLUMNS };
+
+static const char *calStatsColumns[CAL_NCOLUMNS] =
+    { "chan", "mon", "queue", "repl/s", "out/s", "in/s", "put/s" };
+
+struct calStatsRow {
+    struct calClient *c;
+    double value[CAL_NCOLUMNS];     /* < 0: not available */
+    double sortValue;               /* value of the sort column */
+};
+
+static int calStatsCompare(const void *a, const void *b)
+{
+    double va = ((const struct calStatsRow *)a)->sortValue;
+    double vb = ((const struct calStatsRow *)b)->sortValue;
+    return va < vb ? 1 : va > vb ? -1 : 0;
+}
+
+static const struct calClient *calFindClient(const struct calSnapshot *snap, const struct calClient *c)
+{
+    size_t i;
+
+    for (i = 0; i < snap->nclients; i++)
+    {
+        const struct calClient *o = &snap->clients[i];
+        if (o->id == c->id && o->tid == c->tid && o->addr.sin_port == c->addr.sin_port
+            && o->addr.sin_addr.s_addr == c->addr.sin_addr.s_addr)
+            return o;
+    }
+    return NULL;
+}
+
+/* column index or -1 */
+static int calStatsColumn(const char *sort, const char *cmd)
+{
+    int col;
+
+    if (!sort || !*sort) return CAL_OUT;
+    for (col = 0; col < CAL_NCOLUMNS; col++)
+        if (strncmp(sort, calStatsColumns[col], strlen(sort)) == 0) return col;
+    fprintf(stderr, "%s: unknown column %s\n", cmd, sort);
+    return -1;
+}
+
+static void calPutInit(void *dummy)
+{
+    calPutLock = epicsMutexMustCreate();
+    gphInitPvt(&calPutHash, 256);
+    asTrapWriteRegisterListener(calTrapWriteListener);
+}
+
+static int calStatsSample(struct calSnapshot *snap)
+{
+    size_t i;
+
+    epicsThreadOnce(&calPutOnce, calPutInit, NULL);
+    if (calSnapshotTake(snap, 1) != 0) return -1;
+    for (i = 0; i < snap->nclients; i++)
+        snap->clients[i].puts = calPutCount(&snap->clients[i]);
+    return 0;
+}
+
+/* rates between two samples, sorted by column col */
+static struct calStatsRow *calStatsRows(const struct calSnapshot *before,
+    struct calSnapshot *after, double dt, int col)
+{
+    struct calStatsRow *rows;
+    size_t i;
+
+    rows = calloc(after->nclients + 1, sizeof(struct calStatsRow));
+    if (!rows) return NULL;
+    for (i = 0; i < after->nclients; i++)
+    {
+        struct calClient *c = &after->clients[i];
+        const struct calClient *o = calFindClient(before, c);
+        double *v = rows[i].value;
+
+        rows[i].c = c;
+        calClientRef(c, 0);
+        v[CAL_CHAN] = c->nchannels;
+        v[CAL_MON] = c->nmonitors;
+        v[CAL_QUEUE] = c->queued;
+#ifndef CAL_EVENT_STATS
+        v[CAL_QUEUE] = -1;
+#endif
+        v[CAL_REPL] = v[CAL_OUT] = v[CAL_IN] = v[CAL_PUT] = -1;
+        if (!o) continue;   /* new client */
+#ifdef CAL_EVENT_STATS
+        v[CAL_REPL] = c->replaced >= o->replaced ? (c->replaced - o->replaced) / dt : 0;
+#endif
+#ifdef CAL_TCP_INFO
+        if (calTcpHas(c, bytes_received) && calTcpHas(o, bytes_received))
+        {
+            v[CAL_OUT] = (double)(c->tcpInfo.bytes_acked - o->tcpInfo.bytes_acked) / dt;
+            v[CAL_IN] = (double)(c->tcpInfo.bytes_received - o->tcpInfo.bytes_received) / dt;
+        }
+#endif
+        v[CAL_PUT] = (c->puts - o->puts) / dt;
+    }
+    for (i = 0; i < after->nclients; i++)
+        rows[i].sortValue = rows[i].value[col];
+    qsort(rows, after->nclients, sizeof(struct calStatsRow), calStatsCompare);
+    return rows;
+}
+
+static void calStatsPrint(const struct calStatsRow *rows, size_t n)
+{
+    size_t i;
+    int col;
+
+    for (col = 0; col < CAL_NCOLUMNS; col++)
+        printf("%9s", calStatsColumns[col]);
+    printf(" client\n");
+    for (i = 0; i < n; i++)
+    {
+        for (col = 0; col < CAL_NCOLUMNS; col++)
+        {
+            double v = rows[i].value[col];
+            if (v < 0) printf("%9s", "-");
+            else if (col < CAL_REPL) printf("%9.0f", v);
+            else if (v >= 1e7) printf("%8.1fM", v * 1e-6);
+            else printf("%9.1f", v);
+        }
+        printf(" %s\n", rows[i].c->clientref);
+    }
+}
+
+long calStats(double interval, const char *sort)
+{
+    struct calSnapshot before, after;
+    struct calStatsRow *rows;
+    epicsTimeStamp t0, t1;
+    double dt;
+    int col;
+
+    col = calStatsColumn(sort, "calStats");
+    if (col < 0) return -1;
+    if (interval <= 0) interval = 1.0;
+
+    if (calStatsSample(&before) != 0) return -1;
+    epicsTimeGetCurrent(&t0);
+    epicsThreadSleep(interval);
+    if (calStatsSample(&after) != 0)
+    {
+        calSnapshotFree(&before);
+        return -1;
+    }
+    epicsTimeGetCurrent(&t1);
+    dt = epicsTimeDiffInSeconds(&t1, &t0);
+    if (dt <= 0) dt = interval;
+
+    rows = calStatsRows(&before, &after, dt, col);
+    if (rows)
+    {
+        printf("%.1f s interval, sorted by %s\n", dt, calStatsColumns[col]);
+        calStatsPrint(rows, after.nclients);
+        free(rows);
+    }
+    calSnapshotFree(&before);
+    calSnapshotFree(&after);
+    return 0;
+}
+
+/* fan-out per record.field */
+
+struct calPv {
+    size_t first;                   /* index of first channel in sorted snapshot */
+    size_t nchannels;
+    unsigned long monitors;
+    unsigned long clients;
+    unsigned long duplicates;       /* monitors beyond the first of each client */
+};
+
+static int calChannelCompare(const void *a, const void *b)
+{
+    const struct calChannel *ca = a;
+    const struct calChannel *cb = b;
+    int r;
+
+    r = strcmp(ca->recname, cb->recname);
+    if (r) return r;
+    r = strcmp(ca->fieldname, cb->fieldname);
+    if (r) return r;
+    return ca->client < cb->client ? -1 : ca->client > cb->client;
+}
+
+static int calPvCompare(const void *a, const void *b)
+{
+    const struct calPv *pa = a;
+    const struct calPv *pb = b;
+
+    if (pa->monitors != pb->monitors) return pa->monitors < pb->monitors ? 1 : -1;
+    if (pa->clients != pb->clients) return pa->clients < pb->clients ? 1 : -1;
+    return pa->first < pb->first ? -1 : pa->first > pb->first;
+}
+
+/* print the count fields with most monitors, reorders the channels of snap */
+static int calSummaryPrint(struct calSnapshot *snap, int count, const char *match)
+{
+    struct calPv *pvs;
+    size_t npvs = 0, i, j;
+    unsigned long monitors = 0, duplicates = 0;
+    globMatcher *matcher;
+    char fullname[PVNAME_STRINGSZ+MAX_FIELD_NAME_LENGTH+1];
+    int matchfield;
+
+    if (match && !*match) match = NULL;
+    matchfield = match && strchr(match, '.');
+    for (i = 0; i < snap->nclients; i++)
+        calClientRef(&snap->clients[i], 0);
+
+    /* drop channels not matching, then group by record.field */
+    matcher = globCompile(match);
+    for (i = 0, j = 0; i < snap->nchannels; i++)
+    {
+        struct calChannel *ch = &snap->channels[i];
+        if (!ch->recname) continue;
+        if (match)
+        {
+            sprintf(fullname, "%.*s.%.*s", PVNAME_STRINGSZ, ch->recname,
+                MAX_FIELD_NAME_LENGTH, ch->fieldname);
+            if (!globMatch(matcher, matchfield ? fullname : ch->recname)) continue;
+        }
+        snap->channels[j++] = *ch;
+    }
+    globFree(matcher);
+    snap->nchannels = j;
+    qsort(snap->channels, snap->nchannels, sizeof(struct calChannel), calChannelCompare);
+
+    pvs = calloc(snap->nchannels + 1, sizeof(struct calPv));
+    if (!pvs) return -1;
+    for (i = 0; i < snap->nchannels; i++)
+    {
+        struct calChannel *ch = &snap->channels[i];
+
+        if (i == 0 || strcmp(ch->recname, ch[-1].recname) != 0
+            || strcmp(ch->fieldname, ch[-1].fieldname) != 0)
+        {
+            pvs[npvs].first = i;
+            npvs++;
+        }
+        pvs[npvs - 1].nchannels++;
+        pvs[npvs - 1].monitors += ch->nmonitors;
+    }
+    /* channels of one pv are sorted by client */
+    for (i = 0; i < npvs; i++)
+    {
+        struct calPv *pv = &pvs[i];
+        struct calChannel *ch = &snap->channels[pv->first];
+        size_t k;
+
+        for (j = 0; j < pv->nchannels; j = k)
+        {
+            unsigned long clientMonitors = 0;
+
+            for (k = j; k < pv->nchannels && ch[k].client == ch[j].client; k++)
+                clientMonitors += ch[k].nmonitors;
+            pv->clients++;
+            if (clientMonitors > 1)
+                pv->duplicates += clientMonitors - 1;
+        }
+    }
+    for (i = 0; i < npvs; i++)
+    {
+        monitors += pvs[i].monitors;
+        duplicates += pvs[i].duplicates;
+    }
+    qsort(pvs, npvs, sizeof(struct calPv), calPvCompare);
+
+    printf("%lu clients, %lu channels to %lu pvs, %lu monitors, %lu duplicate monitors\n",
+        (unsigned long)snap->nclients, (unsigned long)snap->nchannels, (unsigned long)npvs,
+        monitors, duplicates);
+    printf("%9s %8s %8s %5s %s\n", "monitors", "clients", "channels", "dups", "pv [duplicate subscribers]");
+    for (i = 0; i < npvs && i < (size_t)count; i++)
+    {
+        struct calPv *pv = &pvs[i];
+        struct calChannel *ch = &snap->channels[pv->first];
+
+        printf("%9lu %8lu %8lu %5lu %s.%s",
+            pv->monitors, pv->clients, (unsigned long)pv->nchannels, pv->duplicates,
+            ch->recname, ch->fieldname);
+        /* clients with more than one monitor on this pv */
+        for (j = 0; j < pv->nchannels; )
+        {
+            size_t k;
+            unsigned long clientMonitors = 0;
+
+            for (k = j; k < pv->nchannels && ch[k].client == ch[j].client; k++)
+                clientMonitors += ch[k].nmonitors;
+            if (clientMonitors > 1)
+                printf(" %s(%lu)", snap->clients[ch[j].client].clientref, clientMonitors);
+            j = k;
+        }
+        printf("\n");
+    }
+    free(pvs);
+    return 0;
+}
+
+long calSummary(int count, const char *match)
+{
+    struct calSnapshot snap;
+    int status;
+
+    if (count <= 0) count = 20;
+    if (calSnapshotTake(&snap, 0) != 0) return -1;
+    status = calSummaryPrint(&snap, count, match);
+    calSnapshotFree(&snap);
+    return status;
+}
+
+#ifdef CAL_TOP
+/*
+    Live view: clients sorted by a statistics column and the fields with
+    most monitors, redrawn every interval until a key is pressed.
+    The terminal is switched to non-canonical mode while running, so
+    that any key ends it without return.
+*/
+
+static int calTopKey(double timeout)
+{
+    fd_set fds;
+    struct timeval tv;
+    char c;
+
+    FD_ZERO(&fds);
+    FD_SET(STDIN_FILENO, &fds);
+    tv.tv_sec = (long)timeout;
+    tv.tv_usec = (long)((timeout - tv.tv_sec) * 1e6);
+    if (select(STDIN_FILENO + 1, &fds, NULL, NULL, &tv) <= 0) return 0;
+    return read(STDIN_FILENO, &c, 1) >= 0;
+}
+
+static int calTopLines(void)
+{
+#ifdef TIOCGWINSZ
+    struct winsize ws;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_row > 10)
+        return ws.ws_row;
+#endif
+    return 24;
+}
+
+long caTop(double interval, const char *sort)
+{
+    struct calSnapshot before, after;
+    struct calStatsRow *rows;
+    struct termios saved, raw;
+    epicsTimeStamp t0, t1;
+    double dt;
+    int col, lines;
+    size_t n;
+
+    col = calStatsColumn(sort, "caTop");
+    if (col < 0) return -1;
+    if (interval <= 0) interval = 2.0;
+    if (!isatty(STDIN_FILENO) || tcgetattr(STDIN_FILENO, &saved) != 0)
+    {
+        fprintf(stderr, "caTop: stdin is not a terminal\n");
+        return -1;
+    }
+    if (calStatsSample(&before) != 0) return -1;
+    raw = saved;
+    raw.c_lflag &= ~(ICANON|ECHO);
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+    tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+    epicsTimeGetCurrent(&t0);
+    printf("caTop: collecting data for %.1f s, press any key to quit\n", interval);
+    fflush(stdout);
+    while (!calTopKey(interval))
+    {
+        if (calStatsSample(&after) != 0) break;
+        epicsTimeGetCurrent(&t1);
+        dt = epicsTimeDiffInSeconds(&t1, &t0);
+        if (dt <= 0) dt = interval;
+        rows = calStatsRows(&before, &after, dt, col);
+        if (!rows)
+        {
+            calSnapshotFree(&after);
+            break;
+        }
+        lines = calTopLines() - 6;
+        n = after.nclients < (size_t)(lines / 2) ? after.nclients : (size_t)(lines / 2);
+        printf("\033[H\033[2J");
+        printf("caTop: %lu clients, %lu channels, %.1f s interval, sorted by %s, any key quits\n",
+            (unsigned long)after.nclients, (unsigned long)after.nchannels,
+            dt, calStatsColumns[col]);
+        calStatsPrint(rows, n);
+        printf("\n");
+        calSummaryPrint(&after, lines - (int)n > 1 ? lines - (int)n - 1 : 0, NULL);
+        fflush(stdout);
+        free(rows);
+        calSnapshotFree(&before);
+        before = after;
+        t0 = t1;
+    }
+    tcsetattr(STDIN_FILENO, TCSANOW, &saved);
+    calSnapshotFree(&before);
+    return 0;
+}
+#endif
+
+#ifdef CAL_TCP_INFO
+/*
+    TCP health per client from TCP_INFO and the socket send queue.
+    Fields newer than the running kernel are shown as -.
+*/
+
+enum { CAL_TCP_RTT, CAL_TCP_RTTVAR, CAL_TCP_RETRANS, CAL_TCP_UNACKED,
+    CAL_TCP_SENDQ, CAL_TCP_NOTSENT, CAL_TCP_WINDOW, CAL_TCP_NCOLUMNS };
+
+static const char *calTcpColumns[CAL_TCP_NCOLUMNS] =
+    { "rtt/ms", "rttvar", "retrans", "unacked", "sendq", "notsent", "window" };
+
+struct calTcpRow {
+    struct calClient *c;
+    double value[CAL_TCP_NCOLUMNS];     /* < 0: not available */
+};
+
+static int calTcpSortColumn;
+
+static int calTcpCompare(const void *a, const void *b)
+{
+    double va = ((const struct calTcpRow *)a)->value[calTcpSortColumn];
+    double vb = ((const struct calTcpRow *)b)->value[calTcpSortColumn];
+    return va < vb ? 1 : va > vb ? -1 : 0;
+}
+
+long calTcp(const char *sort)
+{
+    struct calSnapshot snap;
+    struct calTcpRow *rows;
+    size_t i, n = 0;
+    int col;
+
+    calTcpSortColumn = CAL_TCP_SENDQ;
+    if (sort && *sort)
+    {
+        for (col = 0; col < CAL_TCP_NCOLUMNS; col++)
+            if (strncmp(sort, calTcpColumns[col], strlen(sort)) == 0) break;
+        if (col == CAL_TCP_NCOLUMNS)
+        {
+            fprintf(stderr, "calTcp: unknown column %s\n", sort);
+            return -1;
+        }
+        calTcpSortColumn = col;
+    }
+    if (calSnapshotTake(&snap, 1) != 0) return -1;
+    rows = calloc(snap.nclients + 1, sizeof(struct calTcpRow));
+    if (!rows)
+    {
+        calSnapshotFree(&snap);
+        return -1;
+    }
+    for (i = 0; i < snap.nclients; i++)
+    {
+        struct calClient *c = &snap.clients[i];
+        const struct calTcpInfo *t = &c->tcpInfo;
+        double *v = rows[n].value;
+
+        if (c->proto != IPPROTO_TCP) continue;
+        calClientRef(c, 0);
+        rows[n++].c = c;
+        for (col = 0; col < CAL_TCP_NCOLUMNS; col++) v[col] = -1;
+        if (calTcpHas(c, total_retrans))
+        {
+            v[CAL_TCP_RTT] = t->rtt * 1e-3;
+            v[CAL_TCP_RTTVAR] = t->rttvar * 1e-3;
+            v[CAL_TCP_RETRANS] = t->total_retrans;
+            v[CAL_TCP_UNACKED] = t->unacked;
+        }
+        v[CAL_TCP_SENDQ] = c->sendQueue;
+        if (calTcpHas(c, notsent_bytes))
+            v[CAL_TCP_NOTSENT] = t->notsent_bytes;
+        /* 1: peer receive window full (zero window probes or window below one segment) */
+        if (calTcpHas(c, snd_wnd))
+            v[CAL_TCP_WINDOW] = t->snd_wnd < t->snd_mss || t->probes > 0;
+        else if (calTcpHas(c, probes))
+            v[CAL_TCP_WINDOW] = t->probes > 0 ? 1 : -1;
+    }
+    qsort(rows, n, sizeof(struct calTcpRow), calTcpCompare);
+
+    for (col = 0; col < CAL_TCP_NCOLUMNS; col++)
+        printf("%9s", calTcpColumns[col]);
+    printf(" client\n");
+    for (i = 0; i < n; i++)
+    {
+        for (col = 0; col < CAL_TCP_NCOLUMNS; col++)
+        {
+            double v = rows[i].value[col];
+            if (v < 0) printf("%9s", "-");
+            else if (col == CAL_TCP_WINDOW) printf("%9s", v ? "FULL" : "ok");
+            else if (col <= CAL_TCP_RTTVAR) printf("%9.2f", v);
+            else printf("%9.0f", v);
+        }
+        printf(" %s\n", rows[i].c->clientref);
+    }
+    free(rows);
+    calSnapshotFree(&snap);
+    return 0;
+}
+#endif
+
+/*
+    Bandwidth estimate.
+    rsrv stores the payload size of every monitor (the DBR type and
+    count requested by the client), but does not count events. To
+    measure the event rates, caBandwidth subscribes itself to every
+    monitored field with the union of the event masks of the clients
+    and counts the events during the interval. Multiplying with the
+    bytes per event of all monitors gives the expected outgoing traffic.
+    Dynamic arrays are counted with their maximum size, deadband filters
+    of clients are ignored, so this is an upper bound.
+*/
+
+#define CA_BW_LARGE 1024            /* bytes per event */
+#define CA_BW_FAST 10               /* events per second */
+
+#ifdef CAL_EVENT_STATS
+#define caBwChan dbChannel
+#else
+#define caBwChan dbAddr
+#endif
+
+#define CA_BW_KEY_LENGTH (PVNAME_STRINGSZ+MAX_FIELD_NAME_LENGTH+12)
+
+struct caBwField {
+    char key[CA_BW_KEY_LENGTH];     /* name and mask */
+    char name[PVNAME_STRINGSZ+MAX_FIELD_NAME_LENGTH+1];
+    size_t recnameLength;
+    unsigned int mask;
+    unsigned long nmonitors;
+    unsigned long eventSize;        /* bytes per event, all monitors */
+    unsigned long maxEventSize;
+    unsigned long events;           /* counted by our subscription */
+    double rate;
+    dbEventSubscription sub;
+#ifdef CAL_EVENT_STATS
+    dbChannel *chan;
+#else
+    DBADDR addr;
+#endif
+};
+
+struct caBwRow {
+    const char *name;
+    size_t nameLength;
+    double bytes;
+    double events;
+    unsigned long nmonitors;
+};
+
+static void caBwEvent(void *user_arg, struct caBwChan *chan, int eventsRemaining, struct db_field_log *pfl)
+{
+    ((struct caBwField *)user_arg)->events++;
+}
+
+static int caBwRowCompare(const void *a, const void *b)
+{
+    double ba = ((const struct caBwRow *)a)->bytes;
+    double bb = ((const struct caBwRow *)b)->bytes;
+    return ba < bb ? 1 : ba > bb ? -1 : 0;
+}
+
+static int caBwFieldCompare(const void *a, const void *b)
+{
+    return strcmp((*(struct caBwField *const *)a)->name, (*(struct caBwField *const *)b)->name);
+}
+
+static int caBwHasDeadband(const struct caBwField *field)
+{
+    char name[PVNAME_STRINGSZ+6];
+    DBADDR addr;
+    double mdel = 0;
+    long n = 1;
+
+    sprintf(name, "%.*s.MDEL", (int)field->recnameLength, field->name);
+    if (dbNameToAddr(name, &addr) != 0) return 0;
+    if (dbGetField(&addr, DBR_DOUBLE, &mdel, NULL, &n, NULL) != 0) return 0;
+    return mdel > 0;
+}
+
+static void caBwPrint(struct caBwRow *rows, size_t n, int count, const char *what)
+{
+    size_t i;
+
+    qsort(rows, n, sizeof(struct caBwRow), caBwRowCompare);
+    printf("%11s %9s %9s %s\n", "bytes/s", "events/s", "monitors", what);
+    for (i = 0; i < n && i < (size_t)count; i++)
+        printf("%11.0f %9.1f %9lu %.*s\n", rows[i].bytes, rows[i].events,
+            rows[i].nmonitors, (int)rows[i].nameLength, rows[i].name);
+}
+
+/* subscribe to all fields, count events for interval seconds */
+static double caBwMeasure(struct caBwField **fields, size_t nfields, double interval)
+{
+    dbEventCtx ctx;
+    epicsTimeStamp start, end;
+    size_t i;
+
+    ctx = db_init_events();
+    if (!ctx || db_start_events(ctx, "caBandwidth", NULL, NULL, epicsThreadPriorityCAServerHigh) != 0)
+    {
+        fprintf(stderr, "caBandwidth: can't start event task\n");
+        if (ctx) db_close_events(ctx);
+        return 0;
+    }
+    for (i = 0; i < nfields; i++)
+    {
+        struct caBwField *field = fields[i];
+#ifdef CAL_EVENT_STATS
+        field->chan = dbChannelCreate(field->name);
+        if (field->chan && dbChannelOpen(field->chan) != 0)
+        {
+            dbChannelDelete(field->chan);
+            field->chan = NULL;
+        }
+        if (!field->chan) continue;
+        field->sub = db_add_event(ctx, field->chan, caBwEvent, field, field->mask);
+#else
+        if (dbNameToAddr(field->name, &field->addr) != 0) continue;
+        field->sub = db_add_event(ctx, &field->addr, caBwEvent, field, field->mask);
+#endif
+    }
+    epicsTimeGetCurrent(&start);
+    for (i = 0; i < nfields; i++)
+        if (fields[i]->sub) db_event_enable(fields[i]->sub);
+    epicsThreadSleep(interval);
+    for (i = 0; i < nfields; i++)
+        if (fields[i]->sub) db_cancel_event(fields[i]->sub);
+    epicsTimeGetCurrent(&end);
+    db_close_events(ctx);
+#ifdef CAL_EVENT_STATS
+    for (i = 0; i < nfields; i++)
+        if (fields[i]->chan) dbChannelDelete(fields[i]->chan);
+#endif
+    return epicsTimeDiffInSeconds(&end, &start);
+}
+
+long caBandwidth(double interval, int count)
+{
+    struct calSnapshot before, after;
+    struct gphPvt *hash = NULL;
+    struct caBwField **fields = NULL, **chfield = NULL;
+    struct caBwRow *rows = NULL;
+    size_t nfields = 0, nrows, i, j;
+    unsigned long nmonitors = 0;
+    double dt, total = 0, measured = -1;
+    int flagged = 0;
+    long status = -1;
+
+    if (interval <= 0) interval = 1;
+    if (count <= 0) count = 10;
+    if (calSnapshotTake(&before, 1) != 0) return -1;
+    memset(&after, 0, sizeof(after));
+    fields = calloc(before.nchannels + 1, sizeof(struct caBwField *));
+    chfield = calloc(before.nchannels + 1, sizeof(struct caBwField *));
+    rows = calloc(before.nchannels + before.nclients + 1, sizeof(struct caBwRow));
+    if (!fields || !chfield || !rows)
+    {
+        fprintf(stderr, "caBandwidth: out of memory\n");
+        goto end;
+    }
+
+    /* one subscription per field and event mask */
+    gphInitPvt(&hash, 1024);
+    for (i = 0; i < before.nchannels; i++)
+    {
+        struct calChannel *ch = &before.channels[i];
+        char key[CA_BW_KEY_LENGTH];
+        struct caBwField *field;
+        GPHENTRY *pgph;
+
+        if (!ch->nmonitors || !ch->recname) continue;
+        sprintf(key, "%.*s.%.*s %x", PVNAME_STRINGSZ, ch->recname,
+            MAX_FIELD_NAME_LENGTH, ch->fieldname, ch->mask);
+        pgph = gphFind(hash, key, &hash);
+        if (pgph) field = pgph->userPvt;
+        else
+        {
+            field = calloc(1, sizeof(struct caBwField));
+            if (!field)
+            {
+                fprintf(stderr, "caBandwidth: out of memory\n");
+                goto end;
+            }
+            fields[nfields++] = field;
+            strcpy(field->key, key);
+            sprintf(field->name, "%.*s.%.*s", PVNAME_STRINGSZ, ch->recname,
+                MAX_FIELD_NAME_LENGTH, ch->fieldname);
+            field->recnameLength = strlen(ch->recname);
+            field->mask = ch->mask;
+            pgph = gphAdd(hash, field->key, &hash);
+            if (pgph) pgph->userPvt = field;
+        }
+        field->nmonitors += ch->nmonitors;
+        field->eventSize += ch->eventSize;
+        if (ch->maxEventSize > field->maxEventSize) field->maxEventSize = ch->maxEventSize;
+        chfield[i] = field;
+    }
+
+    dt = caBwMeasure(fields, nfields, interval);
+    if (dt <= 0) goto end;
+    if (calSnapshotTake(&after, 1) != 0) goto end;
+    for (i = 0; i < nfields; i++)
+    {
+        fields[i]->rate = fields[i]->events / dt;
+        total += fields[i]->rate * fields[i]->eventSize;
+    }
+#ifdef CAL_TCP_INFO
+    measured = 0;
+    for (i = 0; i < after.nclients; i++)
+    {
+        const struct calClient *c = &after.clients[i];
+        const struct calClient *o = calFindClient(&before, c);
+        if (o && calTcpHas(c, bytes_acked) && calTcpHas(o, bytes_acked))
+            measured += c->tcpInfo.bytes_acked - o->tcpInfo.bytes_acked;
+    }
+    measured /= dt;
+#endif
+    for (i = 0; i < nfields; i++)
+        nmonitors += fields[i]->nmonitors;
+    printf("%lu monitors on %lu fields for %lu clients in %.1f s: %.0f bytes/s expected",
+        nmonitors, (unsigned long)nfields, (unsigned long)before.nclients, dt, total);
+    if (measured >= 0) printf(", %.0f bytes/s sent to all clients\n", measured);
+    else printf("\n");
+
+    /* per client */
+    nrows = 0;
+    for (i = 0; i < before.nclients; i++)
+    {
+        calClientRef(&before.clients[i], 0);
+        rows[i].name = before.clients[i].clientref;
+        rows[i].nameLength = strlen(rows[i].name);
+    }
+    for (i = 0; i < before.nchannels; i++)
+    {
+        struct caBwRow *row = &rows[before.channels[i].client];
+        if (!chfield[i]) continue;
+        row->bytes += chfield[i]->rate * before.channels[i].eventSize;
+        row->events += chfield[i]->rate * before.channels[i].nmonitors;
+        row->nmonitors += before.channels[i].nmonitors;
+    }
+    for (i = 0; i < before.nclients; i++)
+        if (rows[i].nmonitors) rows[nrows++] = rows[i];
+    caBwPrint(rows, nrows, count, "client");
+
+    /* per record */
+    qsort(fields, nfields, sizeof(struct caBwField *), caBwFieldCompare);
+    memset(rows, 0, (before.nchannels + before.nclients + 1) * sizeof(struct caBwRow));
+    nrows = 0;
+    for (i = 0; i < nfields; i = j)
+    {
+        struct caBwRow *row = &rows[nrows++];
+        row->name = fields[i]->name;
+        row->nameLength = fields[i]->recnameLength;
+        for (j = i; j < nfields && fields[j]->recnameLength == row->nameLength
+            && strncmp(fields[j]->name, row->name, row->nameLength) == 0; j++)
+        {
+            row->bytes += fields[j]->rate * fields[j]->eventSize;
+            row->events += fields[j]->rate * fields[j]->nmonitors;
+            row->nmonitors += fields[j]->nmonitors;
+        }
+    }
+    caBwPrint(rows, nrows, count, "record");
+
+    for (i = 0; i < nfields; i++)
+    {
+        struct caBwField *field = fields[i];
+        if (field->maxEventSize < CA_BW_LARGE || field->rate < CA_BW_FAST) continue;
+        if ((field->mask & DBE_VALUE) && caBwHasDeadband(field)) continue;
+        if (!flagged++)
+            printf("large arrays at high rate without deadband:\n%11s %9s %9s %s\n",
+                "bytes/s", "events/s", "bytes", "field");
+        printf("%11.0f %9.1f %9lu %s\n", field->rate * field->eventSize,
+            field->rate, field->maxEventSize, field->name);
+    }
+    status = 0;
+end:
+    if (hash) gphFreeMem(hash);
+    for (i = 0; i < nfields; i++) free(fields[i]);
+    free(fields);
+    free(chfield);
+    free(rows);
+    calSnapshotFree(&before);
+    calSnapshotFree(&after);
+    return status;
+}
+
+/*
+    Name search sampling.
+    The CA server does not count search requests. The UDP server thread
+    receives each datagram into the recv buffer of its client and sets
+    time_at_last_recv. Polling that time stamp and copying the buffer
+    sees a sample of the datagrams, at most one per poll, which is enough
+    to find the hosts and names that dominate a search storm. There is no
+    search hook in rsrv. Each sample looks up the UDP clients again with
+    LOCK_CLIENTQ held and copies the buffer with the client lock held,
+    which keeps the client alive and excludes the replies. The UDP
+    thread receives without a lock, thus copies where the time stamp
+    changed are dropped, but a datagram received during the copy may
+    still go unnoticed. Thus only counts within the sample are shown,
+    no rates.
+*/
+
+#define CAL_SEARCH_POLL 0.001
+#define CAL_SEARCH_MAX_UDP 16
+#define CAL_SEARCH_BUFFER 0x10000
+
+struct calSearchCount {
+    unsigned long requests;
+    unsigned long missing;          /* hosts: requests for names not found */
+    int exists;                     /* names: name is served by this IOC */
+    char key[1];
+};
+
+struct calSearchTable {
+    struct calSearchCount **items;
+    size_t n, size;
+};
+
+struct calSearch {
+    struct gphPvt *hash;
+    struct calSearchTable hosts;
+    struct calSearchTable names;
+    unsigned long datagrams;
+    unsigned long requests;
+    unsigned long missing;
+    unsigned long dropped;
+};
+
+static int calSearchNameExists(const char *name)
+{
+    char pvname[PVNAME_STRINGSZ+MAX_FIELD_NAME_LENGTH+1];
+    DBADDR addr;
+
+    /* long string ($) and channel filter ({}) modifiers */
+    calCopyString(pvname, sizeof(pvname), name);
+    pvname[strcspn(pvname, "${")] = 0;
+    return dbNameToAddr(pvname, &addr) == 0;
+}
+
+static struct calSearchCount *calSearchFind(struct calSearch *search,
+    struct calSearchTable *table, const char *key)
+{
+    GPHENTRY *pgph;
+    struct calSearchCount *count;
+
+    pgph = gphFind(search->hash, key, table);
+    if (pgph) return pgph->userPvt;
+    if (table->n == table->size)
+    {
+        size_t size = table->size ? table->size * 2 : 256;
+        struct calSearchCount **items = realloc(table->items, size * sizeof(*items));
+        if (!items) return NULL;
+        table->items = items;
+        table->size = size;
+    }
+    count = calloc(1, sizeof(struct calSearchCount) + strlen(key));
+    if (!count) return NULL;
+    strcpy(count->key, key);
+    pgph = gphAdd(search->hash, count->key, table);
+    if (!pgph)
+    {
+        free(count);
+        return NULL;
+    }
+    pgph->userPvt = count;
+    table->items[table->n++] = count;
+    if (table == &search->names)
+        count->exists = calSearchNameExists(key);
+    return count;
+}
+
+static void calSearchDatagram(struct calSearch *search, const struct sockaddr_in *from,
+    const char *buffer, size_t size)
+{
+    char hostname[16];
+    unsigned long ip = ntohl(from->sin_addr.s_addr);
+    struct calSearchCount *host;
+    size_t offset = 0;
+
+    sprintf(hostname, "%lu.%lu.%lu.%lu",
+        (ip >> 24) & 0xff, (ip >> 16) & 0xff, (ip >> 8) & 0xff, ip & 0xff);
+    host = calSearchFind(search, &search->hosts, hostname);
+    search->datagrams++;
+    while (offset + sizeof(caHdr) <= size)
+    {
+        caHdr header;
+        unsigned int postsize;
+        const char *name;
+        struct calSearchCount *count;
+
+        memcpy(&header, buffer + offset, sizeof(caHdr));
+        postsize = ntohs(header.m_postsize);
+        offset += sizeof(caHdr);
+        if (postsize == 0xffff || offset + postsize > size) break;
+        name = buffer + offset;
+        offset += postsize;
+        if (ntohs(header.m_cmmd) != CA_PROTO_SEARCH || postsize == 0) continue;
+        if (!memchr(name, 0, postsize)) continue;
+        count = calSearchFind(search, &search->names, name);
+        search->requests++;
+        if (host) host->requests++;
+        if (!count) continue;
+        count->requests++;
+        if (!count->exists)
+        {
+            search->missing++;
+            if (host) host->missing++;
+        }
+    }
+}
+
+struct calSearchSample {
+    struct client *client;          /* only used as key outside LOCK_CLIENTQ */
+    epicsTimeStamp last;
+    struct sockaddr_in from;
+    size_t offset, size;
+    int copied;
+};
+
+/* copy new datagrams of all UDP clients into buffer,
+   clients are looked up again each time because they may have gone */
+static size_t calSearchSample(struct calSearch *search, struct calSearchSample *sample,
+    size_t n, char *buffer, int first)
+{
+    struct calSearchSample previous[CAL_SEARCH_MAX_UDP];
+    struct client *udp[CAL_SEARCH_MAX_UDP];
+    struct client *client;
+    size_t i, j, m = 0, used = 0;
+
+    memcpy(previous, sample, n * sizeof(struct calSearchSample));
+    LOCK_CLIENTQ
+#ifdef CAL_CAST_CLIENT
+    if (prsrv_cast_client) udp[m++] = prsrv_cast_client;
+#endif
+    for (client = (struct client *)ellNext(&clientQ.node); client; client = (struct client *)ellNext(&client->node))
+        if (client->proto == IPPROTO_UDP && m < CAL_SEARCH_MAX_UDP) udp[m++] = client;
+    for (i = 0; i < m; i++)
+    {
+        struct calSearchSample *s = &sample[i];
+        epicsTimeStamp t;
+        size_t size;
+
+        client = udp[i];
+        memset(s, 0, sizeof(struct calSearchSample));
+        s->client = client;
+        epicsMutexMustLock(client->lock);
+        t = client->time_at_last_recv;
+        s->last = t;
+        for (j = 0; j < n; j++)
+            if (previous[j].client == client) break;
+        /* new clients: only datagrams received from now on */
+        if (first || j == n || (t.secPastEpoch == previous[j].last.secPastEpoch && t.nsec == previous[j].last.nsec))
+        {
+            epicsMutexUnlock(client->lock);
+            continue;
+        }
+        size = client->recv.cnt;
+        if (size > client->recv.maxstk) size = client->recv.maxstk;
+        if (size > CAL_SEARCH_BUFFER - used)
+        {
+            epicsMutexUnlock(client->lock);
+            search->dropped++;
+            continue;
+        }
+        s->from = client->addr;
+        memcpy(buffer + used, client->recv.buf, size);
+        t = client->time_at_last_recv;
+        epicsMutexUnlock(client->lock);
+        /* the UDP thread receives without holding client->lock */
+        if (t.secPastEpoch != s->last.secPastEpoch || t.nsec != s->last.nsec)
+        {
+            search->dropped++;
+            continue;
+        }
+        s->offset = used;
+        s->size = size;
+        s->copied = 1;
+        used += size;
+    }
+    UNLOCK_CLIENTQ
+    return m;
+}
+
+static int calSearchCompare(const void *a, const void *b)
+{
+    unsigned long ra = (*(struct calSearchCount *const *)a)->requests;
+    unsigned long rb = (*(struct calSearchCount *const *)b)->requests;
+    return ra < rb ? 1 : ra > rb ? -1 : 0;
+}
+
+long calSearch(double interval, int count)
+{
+    struct calSearch search;
+    struct calSearchSample sample[CAL_SEARCH_MAX_UDP];
+    epicsTimeStamp start, now;
+    char *buffer;
+    double dt;
+    size_t i, n;
+
+    if (interval <= 0) interval = 1;
+    if (count <= 0) count = 10;
+    buffer = malloc(CAL_SEARCH_BUFFER);
+    if (!buffer)
+    {
+        fprintf(stderr, "calSearch: out of memory\n");
+        return -1;
+    }
+    memset(&search, 0, sizeof(search));
+    gphInitPvt(&search.hash, 1024);
+    n = calSearchSample(&search, sample, 0, buffer, 1);
+    if (n == 0)
+        fprintf(stderr, "calSearch: no CA UDP server found\n");
+
+    epicsTimeGetCurrent(&start);
+    do {
+        epicsThreadSleep(CAL_SEARCH_POLL);
+        n = calSearchSample(&search, sample, n, buffer, 0);
+        for (i = 0; i < n; i++)
+            if (sample[i].copied)
+                calSearchDatagram(&search, &sample[i].from, buffer + sample[i].offset, sample[i].size);
+        epicsTimeGetCurrent(&now);
+        dt = epicsTimeDiffInSeconds(&now, &start);
+    } while (dt < interval);
+    free(buffer);
+
+    printf("unsynchronized sample of %lu datagrams in %.1f s: %lu search requests, %lu for names not on this IOC\n",
+        search.datagrams, dt, search.requests, search.missing);
+    if (search.dropped)
+        printf("%lu datagrams overwritten while copying\n", search.dropped);
+    qsort(search.hosts.items, search.hosts.n, sizeof(struct calSearchCount *), calSearchCompare);
+    qsort(search.names.items, search.names.n, sizeof(struct calSearchCount *), calSearchCompare);
+    if (search.hosts.n)
+        printf("%9s %9s host\n", "sampled", "missing");
+    for (i = 0; i < search.hosts.n && i < (size_t)count; i++)
+        printf("%9lu %9lu %s\n", search.hosts.items[i]->requests,
+            search.hosts.items[i]->missing, search.hosts.items[i]->key);
+    if (search.names.n)
+        printf("%9s name\n", "sampled");
+    for (i = 0; i < search.names.n && i < (size_t)count; i++)
+        printf("%9lu %s%s\n", search.names.items[i]->requests,
+            search.names.items[i]->key, search.names.items[i]->exists ? "" : " (not found)");
+
+    for (i = 0; i < search.hosts.n; i++) free(search.hosts.items[i]);
+    for (i = 0; i < search.names.n; i++) free(search.names.items[i]);
+    free(search.hosts.items);
+    free(search.names.items);
+    gphFreeMem(search.hash);
+    return 0;
+}
+
+/*
+    Slow consumer detection.
+    A thread samples all clients periodically and reports clients that
+    make the server replace (i.e. drop) events in their queues, whose
+    event backlog keeps growing or whose receive window is full.
+    Reports go to errlog, at most once per calWatchReportPeriod seconds
+    per client and at most CAL_WATCH_MAX_REPORTS per sample.
+*/
+
+#define CAL_WATCH_GROWING 3         /* samples with growing queue to report */
+#define CAL_WATCH_MAX_REPORTS 10
+
+static double calWatchInterval;       /* protected by calWatchLock */
+static int calWatchRunning;
+static epicsMutexId calWatchLock;
+static epicsEventId calWatchWakeup;
+
+static int calWatchCheck(struct calClient *c, const struct calClient *o,
+    double dt, const epicsTimeStamp *now, char *reason)
+{
+    int n = 0;
+
+    reason[0] = 0;
+    c->reported = o->reported;
+    c->lastReport = o->lastReport;
+    if (c->queued > o->queued && c->queued > 1) c->growing = o->growing + 1;
+    if (c->replaced > o->replaced)
+        n += sprintf(reason + n, " %.1f events/s replaced in queue",
+            (c->replaced - o->replaced) / dt);
+    if (c->growing >= CAL_WATCH_GROWING)
+        n += sprintf(reason + n, " queue growing to %lu events", c->queued);
+#ifdef CAL_TCP_INFO
+    if (calTcpHas(c, rwnd_limited) && calTcpHas(o, rwnd_limited) &&
+        (c->tcpInfo.rwnd_limited - o->tcpInfo.rwnd_limited) * 1e-6 > dt / 2)
+        n += sprintf(reason + n, " receive window full %.0f%% of time, %u bytes not sent",
+            (c->tcpInfo.rwnd_limited - o->tcpInfo.rwnd_limited) * 1e-4 / dt,
+            c->tcpInfo.notsent_bytes);
+#endif
+    if (!n) return 0;
+    if (c->reported && epicsTimeDiffInSeconds(now, &c->lastReport) < calWatchReportPeriod)
+        return 0;
+    c->reported = 1;
+    c->lastReport = *now;
+    return 1;
+}
+
+static void calWatchLoop(void *dummy)
+{
+    struct calSnapshot before, after;
+    epicsTimeStamp t0, t1;
+    char reason[256];
+    size_t i;
+
+    memset(&before, 0, sizeof(before));
+    epicsTimeGetCurrent(&t0);
+    while (1)
+    {
+        int reports = 0, suppressed = 0;
+        double interval;
+
+        if (calSnapshotTake(&after, 1) != 0)
+        {
+            epicsMutexMustLock(calWatchLock);
+            calWatchRunning = 0;
+            epicsMutexUnlock(calWatchLock);
+            break;
+        }
+        epicsTimeGetCurrent(&t1);
+        for (i = 0; i < after.nclients; i++)
+        {
+            struct calClient *c = &after.clients[i];
+            const struct calClient *o = calFindClient(&before, c);
+
+            if (!o || !calWatchCheck(c, o, epicsTimeDiffInSeconds(&t1, &t0), &t1, reason))
+                continue;
+            if (reports++ >= CAL_WATCH_MAX_REPORTS)
+            {
+                suppressed++;
+                continue;
+            }
+            calClientRef(c, 0);
+            errlogPrintf("cal: slow CA client %s:%s\n", c->clientref, reason);
+        }
+        if (suppressed)
+            errlogPrintf("cal: %d more slow CA clients\n", suppressed);
+        calSnapshotFree(&before);
+        before = after;
+        t0 = t1;
+        epicsMutexMustLock(calWatchLock);
+        interval = calWatchInterval;
+        epicsMutexUnlock(calWatchLock);
+        if (interval > 0)
+            epicsEventWaitWithTimeout(calWatchWakeup, interval);
+        /* re-check: calWatch may have restarted us in the meantime */
+        epicsMutexMustLock(calWatchLock);
+        interval = calWatchInterval;
+        if (interval <= 0) calWatchRunning = 0;
+        epicsMutexUnlock(calWatchLock);
+        if (interval <= 0) break;
+    }
+    calSnapshotFree(&before);
+}
+
+long calWatch(double interval)
+{
+    long status = 0;
+
+    if (!calWatchLock)
+    {
+        calWatchLock = epicsMutexMustCreate();
+        calWatchWakeup = epicsEventMustCreate(epicsEventEmpty);
+    }
+    epicsMutexMustLock(calWatchLock);
+    calWatchInterval = interval;
+    if (interval <= 0)
+    {
+        epicsEventSignal(calWatchWakeup);
+    }
+    else if (!calWatchRunning)
+    {
+        if (epicsThreadCreate("calWatch", epicsThreadPriorityLow,
+            epicsThreadGetStackSize(epicsThreadStackMedium), calWatchLoop, NULL))
+        {
+            calWatchRunning = 1;
+        }
+        else
+        {
+            fprintf(stderr, "calWatch: can't create thread\n");
+            status = -1;
+        }
+    }
+    epicsMutexUnlock(calWatchLock);
+    return status;
+}
+
+/*
+    Put callback (ca_put_callback) latency.
+    rsrv does not time put callbacks and its put notify structure is
+    private. But while a put callback is active, the ppn field of the
+    target record points to the notify structure, which has the channel
+    as usrPvt. A thread polls ppn of all records that have channels with
+    put callbacks (found in a snapshot every CAL_PN_REFRESH seconds)
+    under the record lock. A request is timed from the first poll that
+    sees it to the first one that does not, so the resolution is the
+    poll period and requests that complete within one period are not
+    seen at all. rsrv reuses the notify structure of a channel, and its
+    state is private, so back-to-back requests of the same channel that
+    do not leave the record free at a poll are counted as one long request.
+    That is good enough to find slow asynchronous records.
+*/
+
+#if EPICS_VERSION*10000+EPICS_REVISION*100+EPICS_MODIFICATION > 31500
+#define calNotify processNotify
+#else
+#define calNotify putNotify
+#endif
+
+#define CAL_PN_BUCKETS 24           /* bucket i: latency < 2^i ms */
+#define CAL_PN_REFRESH 1.0
+
+struct calPnStats {
+    unsigned long count;
+    double sum;
+    double max;
+    unsigned long bucket[CAL_PN_BUCKETS];
+    char key[1];
+};
+
+struct calPnTable {
+    struct calPnStats **items;
+    size_t n, size;
+};
+
+struct calPnRecord {
+    struct dbCommon *precord;
+    struct calPnStats *stats;
+    void *ppn;                      /* request seen in the last poll */
+    struct calPnStats *client;      /* NULL if not from a CA client */
+    epicsTimeStamp start;
+};
+
+struct calPnChannel {
+    const void *pciu;
+    struct calPnStats *client;
+};
+
+static double calPnPeriod;            /* protected by calPnLock */
+static int calPnRunning;
+static epicsEventId calPnWakeup;
+static epicsMutexId calPnLock;
+static struct gphPvt *calPnHash;
+static struct calPnTable calPnRecordStats, calPnClientStats;
+static struct calPnRecord **calPnRecords;
+static size_t calPnNRecords, calPnRecordsSize;
+static struct calPnChannel *calPnChannels;
+static size_t calPnNChannels;
+static epicsTimeStamp calPnSince;
+
+static struct calPnStats *calPnStatsFind(struct calPnTable *table, const char *key)
+{
+    GPHENTRY *pgph;
+    struct calPnStats *stats;
+
+    pgph = gphFind(calPnHash, key, table);
+    if (pgph) return pgph->userPvt;
+    if (table->n == table->size)
+    {
+        size_t size = table->size ? table->size * 2 : 64;
+        struct calPnStats **items = realloc(table->items, size * sizeof(*items));
+        if (!items) return NULL;
+        table->items = items;
+        table->size = size;
+    }
+    stats = calloc(1, sizeof(struct calPnStats) + strlen(key));
+    if (!stats) return NULL;
+    strcpy(stats->key, key);
+    pgph = gphAdd(calPnHash, stats->key, table);
+    if (!pgph)
+    {
+        free(stats);
+        return NULL;
+    }
+    pgph->userPvt = stats;
+    table->items[table->n++] = stats;
+    return stats;
+}
+
+static struct calPnRecord *calPnRecordFind(struct dbCommon *precord)
+{
+    GPHENTRY *pgph;
+    struct calPnRecord *r;
+
+    pgph = gphFind(calPnHash, precord->name, &calPnRecords);
+    if (pgph) return pgph->userPvt;
+    if (calPnNRecords == calPnRecordsSize)
+    {
+        size_t size = calPnRecordsSize ? calPnRecordsSize * 2 : 64;
+        struct calPnRecord **records = realloc(calPnRecords, size * sizeof(*records));
+        if (!records) return NULL;
+        calPnRecords = records;
+        calPnRecordsSize = size;
+    }
+    r = calloc(1, sizeof(struct calPnRecord));
+    if (!r) return NULL;
+    r->precord = precord;
+    r->stats = calPnStatsFind(&calPnRecordStats, precord->name);
+    pgph = gphAdd(calPnHash, precord->name, &calPnRecords);
+    if (!r->stats || !pgph)
+    {
+        free(r);
+        return NULL;
+    }
+    pgph->userPvt = r;
+    calPnRecords[calPnNRecords++] = r;
+    return r;
+}
+
+static void calPnAdd(struct calPnStats *stats, double ms)
+{
+    int i;
+
+    if (!stats) return;
+    for (i = 0; i < CAL_PN_BUCKETS-1 && ms >= (double)(1ul << i); i++);
+    stats->bucket[i]++;
+    stats->count++;
+    stats->sum += ms;
+    if (ms > stats->max) stats->max = ms;
+}
+
+static double calPnPercentile(const struct calPnStats *stats, double p)
+{
+    unsigned long n = 0;
+    int i;
+
+    for (i = 0; i < CAL_PN_BUCKETS-1; i++)
+    {
+        n += stats->bucket[i];
+        if (n >= p * stats->count) break;
+    }
+    return (double)(1ul << i) < stats->max ? (double)(1ul << i) : stats->max;
+}
+
+static int calPnChannelCompare(const void *a, const void *b)
+{
+    const void *pa = ((const struct calPnChannel *)a)->pciu;
+    const void *pb = ((const struct calPnChannel *)b)->pciu;
+    return pa < pb ? -1 : pa > pb ? 1 : 0;
+}
+
+/* find records and channels with put callbacks */
+static void calPnRefresh(void)
+{
+    struct calSnapshot snap;
+    struct calPnChannel *channels;
+    char key[300];
+    size_t i, n = 0;
+
+    if (calSnapshotTake(&snap, 0) != 0) return;
+    channels = calloc(snap.nchannels + 1, sizeof(struct calPnChannel));
+    epicsMutexMustLock(calPnLock);
+    for (i = 0; channels && i < snap.nchannels; i++)
+    {
+        struct calChannel *ch = &snap.channels[i];
+        struct calClient *c = &snap.clients[ch->client];
+
+        if (!ch->putNotify) continue;
+        calPnRecordFind(ch->precord);
+        calPutKey(key, c->hasUser ? c->user : NULL, c->hasHost ? c->host : NULL);
+        channels[n].pciu = ch->pciu;
+        channels[n].client = calPnStatsFind(&calPnClientStats, key);
+        n++;
+    }
+    if (channels)
+    {
+        qsort(channels, n, sizeof(struct calPnChannel), calPnChannelCompare);
+        free(calPnChannels);
+        calPnChannels = channels;
+        calPnNChannels = n;
+    }
+    epicsMutexUnlock(calPnLock);
+    calSnapshotFree(&snap);
+}
+
+/* called with calPnLock held */
+static void calPnPoll(const epicsTimeStamp *now)
+{
+    size_t i;
+
+    for (i = 0; i < calPnNRecords; i++)
+    {
+        struct calPnRecord *r = calPnRecords[i];
+        struct calPnChannel key, *ch;
+        calNotify *ppn;
+        void *usrPvt = NULL;
+
+        dbScanLock(r->precord);
+        ppn = (calNotify *)r->precord->ppn;
+        if (ppn) usrPvt = ppn->usrPvt;
+        dbScanUnlock(r->precord);
+        if (ppn == r->ppn) continue;
+        if (r->ppn)
+        {
+            double ms = epicsTimeDiffInSeconds(now, &r->start) * 1e3;
+            calPnAdd(r->stats, ms);
+            calPnAdd(r->client, ms);
+        }
+        r->ppn = ppn;
+        if (!ppn) continue;
+        r->start = *now;
+        /* usrPvt is the channel if the request comes from rsrv */
+        key.pciu = usrPvt;
+        ch = bsearch(&key, calPnChannels, calPnNChannels, sizeof(struct calPnChannel), calPnChannelCompare);
+        r->client = ch ? ch->client : NULL;
+    }
+}
+
+static void calPnLoop(void *dummy)
+{
+    epicsTimeStamp now, lastRefresh;
+    double period;
+
+    memset(&lastRefresh, 0, sizeof(lastRefresh));
+    while (1)
+    {
+        epicsTimeGetCurrent(&now);
+        if (epicsTimeDiffInSeconds(&now, &lastRefresh) >= CAL_PN_REFRESH)
+        {
+            calPnRefresh();
+            lastRefresh = now;
+        }
+        epicsMutexMustLock(calPnLock);
+        epicsTimeGetCurrent(&now);
+        calPnPoll(&now);
+        period = calPnPeriod;
+        epicsMutexUnlock(calPnLock);
+        if (period > 0)
+            epicsEventWaitWithTimeout(calPnWakeup, period);
+        /* re-check: calPutNotify may have restarted us in the meantime */
+        epicsMutexMustLock(calPnLock);
+        period = calPnPeriod;
+        if (period <= 0) calPnRunning = 0;
+        epicsMutexUnlock(calPnLock);
+        if (period <= 0) break;
+    }
+}
+
+long calPutNotify(double period)
+{
+    long status = 0;
+
+    if (!calPnWakeup)
+    {
+        calPnWakeup = epicsEventMustCreate(epicsEventEmpty);
+        calPnLock = epicsMutexMustCreate();
+        gphInitPvt(&calPnHash, 256);
+    }
+    epicsMutexMustLock(calPnLock);
+    calPnPeriod = period;
+    if (period <= 0)
+    {
+        epicsEventSignal(calPnWakeup);
+    }
+    else if (!calPnRunning)
+    {
+        epicsTimeGetCurrent(&calPnSince);
+        if (epicsThreadCreate("calPutNotify", epicsThreadPriorityMedium,
+            epicsThreadGetStackSize(epicsThreadStackMedium), calPnLoop, NULL))
+        {
+            calPnRunning = 1;
+        }
+        else
+        {
+            fprintf(stderr, "calPutNotify: can't create thread\n");
+            calPnPeriod = 0;
+            status = -1;
+        }
+    }
+    epicsMutexUnlock(calPnLock);
+    return status;
+}
+
+struct calPnOutstanding {
+    char record[PVNAME_STRINGSZ];
+    char client[300];
+    double ms;
+};
+
+struct calPnRow {
+    unsigned long count;
+    double mean, p50, p99, max;
+    char key[300];
+};
+
+static int calPnRowCompare(const void *a, const void *b)
+{
+    double ma = ((const struct calPnRow *)a)->max;
+    double mb = ((const struct calPnRow *)b)->max;
+    return ma < mb ? 1 : ma > mb ? -1 : 0;
+}
+
+static int calPnOutstandingCompare(const void *a, const void *b)
+{
+    double ma = ((const struct calPnOutstanding *)a)->ms;
+    double mb = ((const struct calPnOutstanding *)b)->ms;
+    return ma < mb ? 1 : ma > mb ? -1 : 0;
+}
+
+/* called with calPnLock held */
+static struct calPnRow *calPnRows(const struct calPnTable *table, size_t *n)
+{
+    struct calPnRow *rows;
+    size_t i;
+
+    *n = 0;
+    rows = calloc(table->n + 1, sizeof(struct calPnRow));
+    if (!rows) return NULL;
+    for (i = 0; i < table->n; i++)
+    {
+        const struct calPnStats *stats = table->items[i];
+        struct calPnRow *row = &rows[*n];
+
+        if (!stats->count) continue;
+        row->count = stats->count;
+        row->mean = stats->sum / stats->count;
+        row->p50 = calPnPercentile(stats, 0.5);
+        row->p99 = calPnPercentile(stats, 0.99);
+        row->max = stats->max;
+        calCopyString(row->key, sizeof(row->key), stats->key);
+        (*n)++;
+    }
+    return rows;
+}
+
+static void calPnPrint(struct calPnRow *rows, size_t n, int count, const char *what)
+{
+    size_t i;
+
+    qsort(rows, n, sizeof(struct calPnRow), calPnRowCompare);
+    printf("%9s %9s %9s %9s %9s %s\n", "count", "mean/ms", "p50/ms", "p99/ms", "max/ms", what);
+    for (i = 0; i < n && i < (size_t)count; i++)
+        printf("%9lu %9.1f %9.1f %9.1f %9.1f %s\n", rows[i].count,
+            rows[i].mean, rows[i].p50, rows[i].p99, rows[i].max, rows[i].key);
+}
+
+long calPutNotifyReport(int count)
+{
+    struct calPnRow *records, *clients;
+    struct calPnOutstanding *outstanding;
+    size_t nrecords, nclients, noutstanding = 0, i;
+    unsigned long total = 0;
+    epicsTimeStamp now;
+    double period, seconds;
+
+    if (count <= 0) count = 10;
+    if (!calPnLock)
+    {
+        fprintf(stderr, "calPutNotifyReport: start calPutNotify first\n");
+        return -1;
+    }
+    epicsMutexMustLock(calPnLock);
+    epicsTimeGetCurrent(&now);
+    period = calPnPeriod;
+    seconds = epicsTimeDiffInSeconds(&now, &calPnSince);
+    records = calPnRows(&calPnRecordStats, &nrecords);
+    clients = calPnRows(&calPnClientStats, &nclients);
+    outstanding = calloc(calPnNRecords + 1, sizeof(struct calPnOutstanding));
+    for (i = 0; outstanding && i < calPnNRecords; i++)
+    {
+        struct calPnRecord *r = calPnRecords[i];
+        if (!r->ppn) continue;
+        calCopyString(outstanding[noutstanding].record, PVNAME_STRINGSZ, r->precord->name);
+        calCopyString(outstanding[noutstanding].client, 300, r->client ? r->client->key : "-");
+        outstanding[noutstanding++].ms = epicsTimeDiffInSeconds(&now, &r->start) * 1e3;
+    }
+    for (i = 0; i < calPnRecordStats.n; i++)
+        total += calPnRecordStats.items[i]->count;
+    epicsMutexUnlock(calPnLock);
+
+    if (!records || !clients || !outstanding)
+    {
+        fprintf(stderr, "calPutNotifyReport: out of memory\n");
+    }
+    else
+    {
+        printf("%lu put callbacks completed in %.0f s, %lu outstanding",
+            total, seconds, (unsigned long)noutstanding);
+        if (period > 0) printf(", resolution %.0f ms\n", period * 1e3);
+        else printf(", sampling stopped\n");
+        calPnPrint(records, nrecords, count, "record");
+        calPnPrint(clients, nclients, count, "client");
+        if (noutstanding)
+        {
+            qsort(outstanding, noutstanding, sizeof(struct calPnOutstanding), calPnOutstandingCompare);
+            printf("%9s record client\n", "age/ms");
+            for (i = 0; i < noutstanding && i < (size_t)count; i++)
+                printf("%9.1f %s %s\n", outstanding[i].ms, outstanding[i].record, outstanding[i].client);
+        }
+    }
+    free(records);
+    free(clients);
+    free(outstanding);
+    return 0;
+}
+
+/*
+    CPU affinity and priority of CA server threads.
+    Each TCP client has a thread CAS-client that receives requests and
+    a thread CAS-event that sends the monitors. Policies are applied in
+    the order they were defined, the first matching one is used.
+    Thread hooks (3.15 and newer) apply the first policy without host
+    pattern to new CAS-client and CAS-event threads as soon as they
+    start. The host of a client is only known later, thus a thread
+    checks the clients every CA_AFFINITY_PERIOD seconds and applies the
+    matching policy once to both threads of each new client.
+    rsrv does not tell which CAS-event thread belongs to which client.
+    It starts the event thread while it sets up the client, thus the
+    thread hook queues new CAS-event threads and they are paired with
+    the clients in the order these show up in the client list. Pairing
+    is only done when the numbers of waiting clients and threads match,
+    else these wait up to CA_AFFINITY_MAX_WAIT checks and are given up.
+    Priorities are only changed if the policy sets one, otherwise the
+    CA priority requested by the client is kept.
+*/
+
+#define CA_AFFINITY_PERIOD 1.0
+#define CA_AFFINITY_MAX_WAIT 5
+#define CA_AFFINITY_MAX_PENDING 64
+#define CA_AFFINITY_ERROR_INTERVAL 60.0
+
+struct caAffinityPolicy {
+    struct caAffinityPolicy *next;
+    char *cpulist;                  /* NULL: affinity unchanged */
+    int priority;                   /* -1: priority unchanged */
+    char *hostpattern;              /* NULL: all clients */
+    globMatcher *matcher;
+    epicsTimeStamp lastError;       /* of setting the affinity */
+    int failed;
+};
+
+struct caAffinityClient {
+    void *id;                       /* struct client pointer, only used as key */
+    epicsThreadId tid;
+    epicsThreadId eventTid;         /* NULL if not (yet) known */
+    char user[40];
+    char host[CAL_HOSTNAME_LENGTH];
+    int hasUser;
+    int hasHost;
+    int wait;                       /* checks waiting for the event thread, -1: given up */
+    int done;                       /* policy applied to client thread after host was known */
+    int eventDone;                  /* policy applied to event thread */
+};
+
+struct caAffinityPending {
+    epicsThreadId tid;
+    int age;                        /* checks since the thread started */
+};
+
+static struct caAffinityPolicy *caAffinityPolicies;
+static epicsMutexId caAffinityLock;
+static epicsThreadId caAffinityThread;
+static struct caAffinityClient *caAffinityApplied;
+static size_t caAffinityNApplied;
+static struct caAffinityPending caAffinityPending[CA_AFFINITY_MAX_PENDING];
+static size_t caAffinityNPending;
+static int caAffinityStarted;       /* clients older than the hooks are not paired */
+
+/* called with caAffinityLock held */
+static struct caAffinityPolicy *caAffinityFind(const struct caAffinityClient *c)
+{
+    struct caAffinityPolicy *policy;
+
+    for (policy = caAffinityPolicies; policy; policy = policy->next)
+    {
+        if (!policy->hostpattern) return policy;
+        if (!c) continue;
+        if ((c->hasHost && globMatch(policy->matcher, c->host))
+            || (c->hasUser && globMatch(policy->matcher, c->user)))
+            return policy;
+    }
+    return NULL;
+}
+
+/* called with caAffinityLock held, errors of a policy at most every CA_AFFINITY_ERROR_INTERVAL */
+static void caAffinityApply(epicsThreadId tid, struct caAffinityPolicy *policy, int affinity)
+{
+    if (affinity && policy->cpulist)
+    {
+        epicsTimeStamp now;
+
+        epicsTimeGetCurrent(&now);
+        if (!policy->failed || epicsTimeDiffInSeconds(&now, &policy->lastError) >= CA_AFFINITY_ERROR_INTERVAL)
+        {
+            policy->failed = threadsSetAffinityList(tid, policy->cpulist) != 0;
+            if (policy->failed)
+            {
+                policy->lastError = now;
+                errlogPrintf("caServerAffinity: can't set affinity %s, retrying in %.0f seconds\n",
+                    policy->cpulist, CA_AFFINITY_ERROR_INTERVAL);
+            }
+        }
+    }
+    if (policy->priority >= 0 && epicsThreadGetPriority(tid) != (unsigned int)policy->priority)
+        epicsThreadSetPriority(tid, policy->priority);
+}
+
+#ifdef CAL_THREAD_HOOKS
+static int caAffinityIsEventThread(epicsThreadId tid)
+{
+    char name[16];
+
+    epicsThreadGetName(tid, name, sizeof(name));
+    return strcmp(name, "CAS-event") == 0;
+}
+
+static void caAffinityThreadStart(epicsThreadId tid)
+{
+    struct caAffinityPolicy *policy;
+    char name[16];
+    int isEvent;
+
+    if (!caAffinityLock) return;
+    epicsThreadGetName(tid, name, sizeof(name));
+    isEvent = strcmp(name, "CAS-event") == 0;
+    if (!isEvent && strcmp(name, "CAS-client") != 0) return;
+    epicsMutexMustLock(caAffinityLock);
+    policy = caAffinityFind(NULL);
+    if (policy) caAffinityApply(tid, policy, 1);
+    if (isEvent && caAffinityNPending < CA_AFFINITY_MAX_PENDING)
+    {
+        caAffinityPending[caAffinityNPending].tid = tid;
+        caAffinityPending[caAffinityNPending].age = 0;
+        caAffinityNPending++;
+    }
+    epicsMutexUnlock(caAffinityLock);
+}
+
+/* pair clients waiting for their event thread with the queued threads,
+   called with caAffinityLock held */
+static void caAffinityPair(struct caAffinityClient *clients, size_t n)
+{
+    size_t i, j, waiting = 0;
+
+    for (i = 0; i < n; i++)
+        if (clients[i].wait >= 0 && !clients[i].eventTid) waiting++;
+    if (waiting && waiting == caAffinityNPending)
+    {
+        for (i = 0, j = 0; i < n; i++)
+            if (clients[i].wait >= 0 && !clients[i].eventTid)
+                clients[i].eventTid = caAffinityPending[j++].tid;
+        caAffinityNPending = 0;
+        return;
+    }
+    for (i = 0; i < n; i++)
+        if (clients[i].wait >= 0 && !clients[i].eventTid && ++clients[i].wait > CA_AFFINITY_MAX_WAIT)
+            clients[i].wait = -1;
+    for (i = 0, j = 0; i < caAffinityNPending; i++)
+        if (++caAffinityPending[i].age <= CA_AFFINITY_MAX_WAIT)
+            caAffinityPending[j++] = caAffinityPending[i];
+    caAffinityNPending = j;
+}
+#endif
+
+static void caAffinityCheck(void)
+{
+    struct client *client;
+    struct caAffinityClient *clients;
+    size_t n = 0, max, i, j;
+
+    LOCK_CLIENTQ
+    max = ellCount(&clientQ);
+    clients = calloc(max + 1, sizeof(struct caAffinityClient));
+    if (clients)
+    for (client = (struct client *)ellNext(&clientQ.node); client && n < max; client = (struct client *)ellNext(&client->node))
+    {
+        struct caAffinityClient *c = &clients[n];
+
+        if (client->proto != IPPROTO_TCP || !client->tid) continue;
+        c->id = client;
+        c->tid = client->tid;
+        c->hasUser = client->pUserName != NULL;
+        if (c->hasUser) calCopyString(c->user, sizeof(c->user), client->pUserName);
+        c->hasHost = client->pHostName != NULL;
+        if (c->hasHost) calCopyString(c->host, sizeof(c->host), client->pHostName);
+        n++;
+    }
+    UNLOCK_CLIENTQ
+    if (!clients) return;
+
+    epicsMutexMustLock(caAffinityLock);
+    for (i = 0; i < n; i++)
+    {
+        struct caAffinityClient *c = &clients[i];
+
+        /* clients that existed before the thread hook was installed */
+        if (!caAffinityStarted) c->wait = -1;
+        for (j = 0; j < caAffinityNApplied; j++)
+            if (caAffinityApplied[j].id == c->id && caAffinityApplied[j].tid == c->tid)
+            {
+                c->eventTid = caAffinityApplied[j].eventTid;
+                c->wait = caAffinityApplied[j].wait;
+                c->done = caAffinityApplied[j].done;
+                c->eventDone = caAffinityApplied[j].eventDone;
+                break;
+            }
+    }
+    caAffinityStarted = 1;
+#ifdef CAL_THREAD_HOOKS
+    caAffinityPair(clients, n);
+#endif
+    for (i = 0; i < n; i++)
+    {
+        struct caAffinityClient *c = &clients[i];
+        struct caAffinityPolicy *policy;
+
+        /* apply once per thread after the host is known */
+        if (!c->hasHost) continue;
+        policy = caAffinityFind(c);
+        if (!c->done)
+        {
+            if (policy) caAffinityApply(c->tid, policy, 1);
+            c->done = 1;
+        }
+        if (c->eventTid && !c->eventDone)
+        {
+            if (policy) caAffinityApply(c->eventTid, policy, 1);
+            c->eventDone = 1;
+        }
+    }
+    free(caAffinityApplied);
+    caAffinityApplied = clients;
+    caAffinityNApplied = n;
+    epicsMutexUnlock(caAffinityLock);
+}
+
+static void caAffinityLoop(void *dummy)
+{
+    while (1)
+    {
+        caAffinityCheck();
+        epicsThreadSleep(CA_AFFINITY_PERIOD);
+    }
+}
+
+#ifdef CAL_THREAD_HOOKS
+/* apply a new policy to the running event threads */
+static void caAffinityExisting(epicsThreadId tid)
+{
+    struct caAffinityPolicy *policy;
+
+    if (!caAffinityIsEventThread(tid)) return;
+    policy = caAffinityFind(NULL);
+    if (policy) caAffinityApply(tid, policy, 1);
+}
+#endif
+
+static void caAffinityShow(void)
+{
+    const struct caAffinityPolicy *policy;
+
+    if (!caAffinityPolicies)
+    {
+        printf("no CA server affinity policies\n");
+        return;
+    }
+    for (policy = caAffinityPolicies; policy; policy = policy->next)
+    {
+        printf("%s: cpus %s", policy->hostpattern ? policy->hostpattern : "all clients",
+            policy->cpulist ? policy->cpulist : "unchanged");
+        if (policy->priority >= 0) printf(", priority %d\n", policy->priority);
+        else printf(", priority unchanged\n");
+    }
+}
+
+long caServerAffinity(const char *cpulist, const char *hostpattern, const char *priority)
+{
+    struct caAffinityPolicy *policy, **last;
+    size_t i;
+
+    if (!caAffinityLock) caAffinityLock = epicsMutexMustCreate();
+    if ((!cpulist || !*cpulist) && (!priority || !*priority))
+    {
+        epicsMutexMustLock(caAffinityLock);
+        caAffinityShow();
+        epicsMutexUnlock(caAffinityLock);
+        return 0;
+    }
+    policy = calloc(1, sizeof(struct caAffinityPolicy));
+    if (!policy)
+    {
+        fprintf(stderr, "caServerAffinity: out of memory\n");
+        return -1;
+    }
+    policy->priority = -1;
+    if (priority && *priority)
+    {
+        policy->priority = threadsStrToPrio(priority, 0);
+        if (policy->priority < 0)
+        {
+            free(policy);
+            return -1;
+        }
+    }
+    if (cpulist && *cpulist) policy->cpulist = epicsStrDup(cpulist);
+    if (hostpattern && *hostpattern)
+    {
+        policy->hostpattern = epicsStrDup(hostpattern);
+        policy->matcher = globCompile(hostpattern);
+    }
+
+    epicsMutexMustLock(caAffinityLock);
+    for (last = &caAffinityPolicies; *last; last = &(*last)->next);
+    *last = policy;
+    /* re-apply the policies to the threads of all clients */
+    for (i = 0; i < caAffinityNApplied; i++)
+        caAffinityApplied[i].done = caAffinityApplied[i].eventDone = 0;
+#ifdef CAL_THREAD_HOOKS
+    if (!policy->hostpattern) epicsThreadMap(caAffinityExisting);
+#endif
+    epicsMutexUnlock(caAffinityLock);
+
+    if (!caAffinityThread)
+    {
+#ifdef CAL_THREAD_HOOKS
+        epicsThreadHookAdd(caAffinityThreadStart);
+#endif
+        caAffinityThread = epicsThreadCreate("caAffinity", epicsThreadPriorityLow,
+            epicsThreadGetStackSize(epicsThreadStackSmall), caAffinityLoop, NULL);
+        if (!caAffinityThread)
+        {
+            fprintf(stderr, "caServerAffinity: can't create thread\n");
+            return -1;
+        }
+    }
+    return 0;
+}
+#endif
+
+#ifndef EPICS_3_13
+static const iocshFuncDef calDef =
+    { "cal", 2, (const iocshArg *[]) {
+    &(iocshArg) { "record name pattern", iocshArgString },
+    &(iocshArg) { "level", iocshArgInt },
+}};
+
+/*
+    cal: List channel access connections
+
+    Shows all channels where record (or record.field if the pattern
+    contains a dot), client user, host or client reference matches.
+    The client and channel lists are copied while the CA server locks
+    are held and printed afterwards, so a slow console does not block
+    the server.
+
+    Level:
+        1 : access rights (w/r/n), m: monitored, p: put-notify pending
+        2 : protocol version and UDP/TCP
+        3 : channel state
+        4 : client thread
+        5 : lock hold time of the snapshot
+*/
+
+void calFunc(const iocshArgBuf *args)
+{
+    cal(args[0].sval, args[1].ival);
+}
+
+static const iocshFuncDef calStatsDef =
+    { "calStats", 2, (const iocshArg *[]) {
+    &(iocshArg) { "interval", iocshArgDouble },
+    &(iocshArg) { "sort column", iocshArgString },
+}};
+
+/*
+    calStats: Show CA traffic per client
+
+    Samples all clients twice, interval seconds apart (default 1),
+    and prints one line per client sorted by the given column
+    (default out/s, highest first). Columns:
+        chan   : number of channels
+        mon    : number of monitors (event subscriptions)
+        queue  : events currently in the queue for the client
+        repl/s : events replaced in the queue because the client did
+                 not read them fast enough (EPICS 3.15 and newer)
+        out/s  : bytes sent and acknowledged by the client (Linux)
+        in/s   : bytes received from the client (Linux)
+        put/s  : puts of user@host to fields with TRAPWRITE rule,
+                 counted from the first call of calStats on
+    There is no column for posted events because the CA server does not
+    count them, only replaced events.
+    Rates of clients that connected during the interval are shown as -.
+    A unique start of the column name is sufficient for sorting.
+*/
+
+void calStatsFunc(const iocshArgBuf *args)
+{
+#ifndef _WIN32
+    calStats(args[0].dval, args[1].sval);
+#endif
+}
+
+static const iocshFuncDef calSummaryDef =
+    { "calSummary", 2, (const iocshArg *[]) {
+    &(iocshArg) { "count", iocshArgInt },
+    &(iocshArg) { "record name pattern", iocshArgString },
+}};
+
+/*
+    calSummary: Show the CA fan-out per record field
+
+    Lists the count (default 20) record fields with the most monitors,
+    together with the number of subscribed clients and channels.
+    Clients holding more than one monitor on the same field are listed
+    with the number of their monitors, these are usually misconfigured
+    clients that waste bandwidth. dups counts the monitors beyond the
+    first of each client.
+*/
+
+void calSummaryFunc(const iocshArgBuf *args)
+{
+#ifndef _WIN32
+    calSummary(args[0].ival, args[1].sval);
+#endif
+}
+
+static const iocshFuncDef calWatchDef =
+    { "calWatch", 1, (const iocshArg *[]) {
+    &(iocshArg) { "interval", iocshArgDouble },
+}};
+
+/*
+    calWatch: Detect slow CA clients
+
+    Starts a thread that samples all CA clients every interval seconds
+    and reports slow clients to errlog. A client is reported if the
+    server had to replace events in its queue because the client did not
+    read them in time, if its event queue grew for 3 samples in a row or
+    if its TCP receive window was full for more than half the interval.
+    Each client is reported at most every calWatchReportPeriod seconds
+    (default 60). calWatch 0 stops the thread.
+*/
+
+void calWatchFunc(const iocshArgBuf *args)
+{
+#ifndef _WIN32
+    calWatch(args[0].dval);
+#endif
+}
+
+static const iocshFuncDef caBandwidthDef =
+    { "caBandwidth", 2, (const iocshArg *[]) {
+    &(iocshArg) { "interval", iocshArgDouble },
+    &(iocshArg) { "count", iocshArgInt },
+}};
+
+/*
+    caBandwidth: Estimate the outgoing CA traffic of monitors
+
+    Counts the events of all monitored fields for interval seconds
+    (default 1) and multiplies them with the bytes per event of each
+    monitor (type and element count requested by the client plus
+    header). Shows the expected total and, on Linux, the bytes actually
+    sent, as well as the count (default 10) clients and records with
+    the highest expected traffic. Fields with more than 1 kB per event,
+    at least 10 events per second and no MDEL deadband are listed
+    separately. Dynamic arrays count with their maximum size, thus this
+    is an upper bound.
+*/
+
+void caBandwidthFunc(const iocshArgBuf *args)
+{
+#ifndef _WIN32
+    caBandwidth(args[0].dval, args[1].ival);
+#endif
+}
+
+static const iocshFuncDef calSearchDef =
+    { "calSearch", 2, (const iocshArg *[]) {
+    &(iocshArg) { "interval", iocshArgDouble },
+    &(iocshArg) { "count", iocshArgInt },
+}};
+
+/*
+    calSearch: Find the sources of CA name searches
+
+    Samples the datagrams received by the CA UDP server for interval
+    seconds (default 1) and shows the count (default 10) hosts and
+    names with the most search requests, and how many of them are for
+    names this IOC does not have. The CA server does not count searches,
+    thus the datagrams are sampled (up to about 1000 per second) without
+    synchronization with the server thread. The output is an unreliable
+    sample, it shows counts within the sample, not rates. To find a client
+    flooding the network with searches, the proportions are what counts.
+*/
+
+void calSearchFunc(const iocshArgBuf *args)
+{
+#ifndef _WIN32
+    calSearch(args[0].dval, args[1].ival);
+#endif
+}
+
+static const iocshFuncDef calPutNotifyDef =
+    { "calPutNotify", 1, (const iocshArg *[]) {
+    &(iocshArg) { "period", iocshArgDouble },
+}};
+
+/*
+    calPutNotify: Time put callbacks (ca_put_callback)
+
+    Starts a thread that checks every period seconds (e.g. 0.01) which
+    records that have CA channels with put callbacks are busy with a put
+    callback, and times the requests per record and per client
+    (user@host). The resolution is the period, requests that complete
+    faster may not be seen. Back-to-back requests of the same channel
+    within one period are merged and counted as one longer request.
+    calPutNotify 0 stops the thread, the statistics are kept.
+*/
+
+void calPutNotifyFunc(const iocshArgBuf *args)
+{
+#ifndef _WIN32
+    calPutNotify(args[0].dval);
+#endif
+}
+
+static const iocshFuncDef calPutNotifyReportDef =
+    { "calPutNotifyReport", 1, (const iocshArg *[]) {
+    &(iocshArg) { "count", iocshArgInt },
+}};
+
+/*
+    calPutNotifyReport: Show put callback latencies
+
+    Shows count (default 10) records and clients with the slowest put
+    callbacks since calPutNotify was started: number, mean, median
+    (p50), 99th percentile and maximum completion time, as well as the
+    requests still outstanding. Percentiles are upper bounds of power
+    of 2 ms histogram buckets.
+*/
+
+void calPutNotifyReportFunc(const iocshArgBuf *args)
+{
+#ifndef _WIN32
+    calPutNotifyReport(args[0].ival);
+#endif
+}
+
+static const iocshFuncDef caServerAffinityDef =
+    { "caServerAffinity", 3, (const iocshArg *[]) {
+    &(iocshArg) { "cpulist", iocshArgString },
+    &(iocshArg) { "host pattern", iocshArgString },
+    &(iocshArg) { "priority", iocshArgString },
+}};
+
+/*
+    caServerAffinity: Set cpu affinity and priority of CA server threads
+
+    Applies the cpulist (as for epicsThreadSetAffinity) and priority
+    (as for epicsThreadSetPriority, empty for unchanged) to the threads
+    of all current and future CA clients, or only to those whose host
+    or user matches the host pattern. Policies are checked in the order
+    they were defined. Without host pattern, the CAS-client and
+    CAS-event threads of a client are set when they start (EPICS 3.15
+    and newer). With host pattern, the CAS-client and CAS-event threads
+    are set once within a second after the client has sent its host
+    name (the CAS-event thread only with 3.15 and newer, and only of
+    clients that connected after the first caServerAffinity call).
+    Without priority, the priority the CA client requested is kept.
+    Failures to set the affinity are reported once per minute.
+    Without arguments, the policies are shown.
+*/
+
+void caServerAffinityFunc(const iocshArgBuf *args)
+{
+#ifndef _WIN32
+    caServerAffinity(args[0].sval, args[1].sval, args[2].sval);
+#endif
+}
+
+#ifdef CAL_TOP
+static const iocshFuncDef caTopDef =
+    { "caTop", 2, (const iocshArg *[]) {
+    &(iocshArg) { "interval", iocshArgDouble },
+    &(iocshArg) { "sort column", iocshArgString },
+}};
+
+/*
+    caTop: Live view of the CA server load
+
+    Redraws the screen every interval seconds (default 2) until a key
+    is pressed. The upper part shows the clients with the columns of
+    calStats, sorted by the given column (default out/s). The lower part
+    shows the record fields with the most monitors like calSummary.
+    Data is sampled, the CA server locks are not held while printing.
+*/
+
+void caTopFunc(const iocshArgBuf *args)
+{
+    caTop(args[0].dval, args[1].sval);
+}
+#endif
+
+#ifdef CAL_TCP_INFO
+static const iocshFuncDef calTcpDef =
+    { "calTcp", 1, (const iocshArg *[]) {
+    &(iocshArg) { "sort column", iocshArgString },
+}};
+
+/*
+    calTcp: Show TCP health of all CA clients (Linux)
+
+    One line per TCP client, sorted by the given column, highest first
+    (default sendq). Columns:
+        rtt/ms  : smoothed round trip time
+        rttvar  : round trip time variation (ms)
+        retrans : total number of retransmitted segments
+        unacked : segments sent but not acknowledged
+        sendq   : bytes in the socket send queue
+        notsent : bytes in the send queue not yet sent
+        window  : FULL if the receive window of the client is full,
+                  i.e. the client does not read fast enough
+*/
+
+void calTcpFunc(const iocshArgBuf *args)
+{
+    calTcp(args[0].sval);
+}
+#endif
+
+static void calRegistrar(void)
+{
+    iocshRegister(&calDef, calFunc);
+    iocshRegister(&calStatsDef, calStatsFunc);
+    iocshRegister(&calSummaryDef, calSummaryFunc);
+    iocshRegister(&calWatchDef, calWatchFunc);
+    iocshRegister(&calSearchDef, calSearchFunc);
+    iocshRegister(&caBandwidthDef, caBandwidthFunc);
+    iocshRegister(&caServerAffinityDef, caServerAffinityFunc);
+    iocshRegister(&calPutNotifyDef, calPutNotifyFunc);
+    iocshRegister(&calPutNotifyReportDef, calPutNotifyReportFunc);
+#ifdef CAL_TOP
+    iocshRegister(&caTopDef, caTopFunc);
+#endif
+#ifdef CAL_TCP_INFO
+    iocshRegister(&calTcpDef, calTcpFunc);
+#endif
 }
 
 epicsExportRegistrar(calRegistrar);
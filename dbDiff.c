@@ -0,0 +1,670 @@
+/* dbDiff.c
+*
+*  compare the records of the running ioc with a reference .db file
+*
+* Copyright (C) 2026 Dirk Zimoch
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <errno.h>
+#include "dbStaticLib.h"
+#include "dbAccess.h"
+#include "dbFldTypes.h"
+#include "epicsTypes.h"
+#include "epicsString.h"
+#include "epicsMutex.h"
+#include "macLib.h"
+#include "osiFileName.h"
+#include "gpHash.h"
+#include "epicsStdioRedirect.h"
+#include "iocsh.h"
+#include "epicsExport.h"
+
+#include "dbWalk.h"
+
+/*
+    The reference file is read with its own small parser (the record
+    types of the file need not be known and nothing is created), macros
+    are expanded line by line. Each record with its field assignments
+    goes into a hash table, thus the comparison with the live database
+    in one dbWalkRecords walk takes linear time. Differences are printed
+    while walking:
+    + record (type)             only in the ioc
+    - record (type)             only in the file
+    ~ record.FIELD "file" -> "ioc"
+    Numbers, menu indices and links are compared by value, not by text,
+    so that "1.0" and "1" or "X" and "X.VAL NPP NMS" are equal.
+*/
+
+#define DBDIFF_MAX_INCLUDE_DEPTH 20
+
+struct dbDiffField {
+    struct dbDiffField *next;
+    const char *name;
+    const char *value;
+};
+
+struct dbDiffRecord {
+    struct dbDiffRecord *next;          /* file order */
+    const char *name;
+    const char *type;
+    struct dbDiffField *fields, **lastField;
+    int seen;
+};
+
+struct dbDiffToken {
+    char *text;
+    char punct;                         /* one of (){}, or 0 for words and strings */
+    int line;
+};
+
+struct dbDiffContext {
+    struct gphPvt *hash;
+    struct dbDiffRecord *records, **lastRecord;
+    size_t nrecords;
+    MAC_HANDLE *mac;
+    char **strings;                     /* all token texts, freed at the end */
+    size_t nstrings, sizestrings;
+    epicsMutexId lock;
+    size_t compared, added, removed, changed;
+};
+
+static char *dbDiffString(struct dbDiffContext *ctx, const char *s, size_t len)
+{
+    char *copy;
+
+    if (ctx->nstrings == ctx->sizestrings)
+    {
+        size_t size = ctx->sizestrings ? ctx->sizestrings * 2 : 4096;
+        char **strings = realloc(ctx->strings, size * sizeof(char *));
+        if (!strings) return NULL;
+        ctx->strings = strings;
+        ctx->sizestrings = size;
+    }
+    copy = malloc(len + 1);
+    if (!copy) return NULL;
+    memcpy(copy, s, len);
+    copy[len] = 0;
+    ctx->strings[ctx->nstrings++] = copy;
+    return copy;
+}
+
+static char *dbDiffReadLine(FILE *file, char **buffer, size_t *size)
+{
+    size_t len = 0;
+
+    while (fgets(*buffer + len, (int)(*size - len), file))
+    {
+        len += strlen(*buffer + len);
+        if ((*buffer)[len-1] == '\n') break;
+        if (len + 1 == *size)
+        {
+            char *b = realloc(*buffer, *size * 2);
+            if (!b) return NULL;
+            *buffer = b;
+            *size *= 2;
+        }
+    }
+    return len ? *buffer : NULL;
+}
+
+static char *dbDiffExpand(struct dbDiffContext *ctx, char *line, char **buffer, size_t *size)
+{
+    long len;
+
+    if (!ctx->mac || !strchr(line, '$')) return line;
+    while ((size_t)labs(len = macExpandString(ctx->mac, line, *buffer, (long)*size - 1)) >= *size - 2)
+    {
+        char *b = realloc(*buffer, *size * 2);
+        if (!b) return line;
+        *buffer = b;
+        *size *= 2;
+    }
+    return *buffer;
+}
+
+/* split one line into tokens like the dbLoadRecords lexer */
+static int dbDiffTokenize(struct dbDiffContext *ctx, const char *p, int line,
+    struct dbDiffToken **tokens, size_t *ntokens, size_t *size)
+{
+    const char *q;
+    struct dbDiffToken *t;
+
+    while (*p)
+    {
+        if (isspace((unsigned char)*p)) { p++; continue; }
+        if (*p == '#') break;
+        if (*ntokens == *size)
+        {
+            size_t newsize = *size ? *size * 2 : 1024;
+            t = realloc(*tokens, newsize * sizeof(struct dbDiffToken));
+            if (!t) return -1;
+            *tokens = t;
+            *size = newsize;
+        }
+        t = &(*tokens)[(*ntokens)++];
+        t->line = line;
+        t->punct = 0;
+        if (strchr("(){},", *p))
+        {
+            t->punct = *p++;
+            t->text = NULL;
+            continue;
+        }
+        if (*p == '"')
+        {
+            for (q = ++p; *q && *q != '"'; q++)
+                if (*q == '\\' && q[1]) q++;
+            t->text = dbDiffString(ctx, p, q - p);
+            if (!t->text) return -1;
+            epicsStrnRawFromEscaped(t->text, q - p + 1, p, q - p);
+            p = *q ? q + 1 : q;
+            continue;
+        }
+        for (q = p; *q && !isspace((unsigned char)*q) && !strchr("(){},\"#", *q); q++);
+        t->text = dbDiffString(ctx, p, q - p);
+        if (!t->text) return -1;
+        p = q;
+    }
+    return 0;
+}
+
+/* parse "( arg, arg, ... )", return number of args or -1 */
+static int dbDiffArgs(const struct dbDiffToken *tokens, size_t ntokens, size_t *i,
+    const char *args[], int maxargs)
+{
+    int nargs = 0;
+
+    if (*i >= ntokens || tokens[*i].punct != '(') return -1;
+    for ((*i)++; *i < ntokens && tokens[*i].punct != ')'; (*i)++)
+    {
+        if (tokens[*i].punct == ',') continue;
+        if (tokens[*i].punct) return -1;
+        if (nargs < maxargs) args[nargs] = tokens[*i].text;
+        nargs++;
+    }
+    if (*i == ntokens) return -1;
+    (*i)++;
+    return nargs;
+}
+
+static void dbDiffSkipBlock(const struct dbDiffToken *tokens, size_t ntokens, size_t *i)
+{
+    int depth = 0;
+
+    if (*i >= ntokens || tokens[*i].punct != '{') return;
+    for (; *i < ntokens; (*i)++)
+    {
+        if (tokens[*i].punct == '{') depth++;
+        if (tokens[*i].punct == '}' && --depth == 0) break;
+    }
+    (*i)++;
+}
+
+static struct dbDiffRecord *dbDiffAddRecord(struct dbDiffContext *ctx, const char *type, const char *name)
+{
+    struct dbDiffRecord *rec;
+    GPHENTRY *pgph;
+
+    pgph = gphFind(ctx->hash, name, ctx);
+    if (pgph)
+    {
+        /* repeated record adds or overwrites fields */
+        rec = pgph->userPvt;
+        if (strcmp(rec->type, "*") == 0) rec->type = type;
+        return rec;
+    }
+    rec = calloc(1, sizeof(struct dbDiffRecord));
+    if (!rec) return NULL;
+    rec->name = name;
+    rec->type = type;
+    rec->lastField = &rec->fields;
+    pgph = gphAdd(ctx->hash, name, ctx);
+    if (!pgph)
+    {
+        free(rec);
+        return NULL;
+    }
+    pgph->userPvt = rec;
+    *ctx->lastRecord = rec;
+    ctx->lastRecord = &rec->next;
+    ctx->nrecords++;
+    return rec;
+}
+
+static int dbDiffSetField(struct dbDiffRecord *rec, const char *name, const char *value)
+{
+    struct dbDiffField *fld;
+
+    for (fld = rec->fields; fld; fld = fld->next)
+        if (strcmp(fld->name, name) == 0)
+        {
+            fld->value = value;
+            return 0;
+        }
+    fld = calloc(1, sizeof(struct dbDiffField));
+    if (!fld) return -1;
+    fld->name = name;
+    fld->value = value;
+    *rec->lastField = fld;
+    rec->lastField = &fld->next;
+    return 0;
+}
+
+static int dbDiffReadFile(struct dbDiffContext *ctx, const char *filename, const char *parent, int depth);
+
+/* path: where the file was found, includes are also searched in its directory */
+static int dbDiffParse(struct dbDiffContext *ctx, const char *filename, const char *path, int depth,
+    const struct dbDiffToken *tokens, size_t ntokens)
+{
+    const char *args[2];
+    const char *keyword;
+    struct dbDiffRecord *rec;
+    size_t i = 0;
+    int nargs;
+
+    while (i < ntokens)
+    {
+        if (tokens[i].punct) goto syntaxError;
+        keyword = tokens[i++].text;
+        if (strcmp(keyword, "include") == 0)
+        {
+            if (i == ntokens || tokens[i].punct) goto syntaxError;
+            if (dbDiffReadFile(ctx, tokens[i++].text, path, depth + 1) != 0) return -1;
+            continue;
+        }
+        nargs = dbDiffArgs(tokens, ntokens, &i, args, 2);
+        if (nargs < 0) goto syntaxError;
+        if ((strcmp(keyword, "record") != 0 && strcmp(keyword, "grecord") != 0) || nargs != 2)
+        {
+            /* alias, path, etc. */
+            dbDiffSkipBlock(tokens, ntokens, &i);
+            continue;
+        }
+        rec = dbDiffAddRecord(ctx, args[0], args[1]);
+        if (!rec) goto noMemory;
+        if (i == ntokens || tokens[i].punct != '{') continue;
+        for (i++; i < ntokens && tokens[i].punct != '}'; )
+        {
+            if (tokens[i].punct) goto syntaxError;
+            keyword = tokens[i++].text;
+            nargs = dbDiffArgs(tokens, ntokens, &i, args, 2);
+            if (nargs < 0) goto syntaxError;
+            if (strcmp(keyword, "field") == 0 && nargs == 2)
+                if (dbDiffSetField(rec, args[0], args[1]) != 0) goto noMemory;
+        }
+        if (i == ntokens) goto syntaxError;
+        i++;
+    }
+    return 0;
+
+syntaxError:
+    fprintf(stderr, "dbDiff: %s line %d: syntax error\n", filename,
+        tokens[i < ntokens ? i : ntokens - 1].line);
+    return -1;
+noMemory:
+    fprintf(stderr, "dbDiff: out of memory\n");
+    return -1;
+}
+
+static FILE *dbDiffOpenIn(const char *dir, size_t dirlen, const char *filename, char **path)
+{
+    char *name = malloc(dirlen + strlen(filename) + 2);
+    FILE *file;
+
+    if (!name) return NULL;
+    if (dirlen)
+    {
+        memcpy(name, dir, dirlen);
+        name[dirlen++] = OSI_PATH_SEPARATOR[0];
+    }
+    strcpy(name + dirlen, filename);
+    file = fopen(name, "r");
+    if (file) *path = name;
+    else free(name);
+    return file;
+}
+
+/* as dbLoadRecords: names with a directory are used as they are, others
+   are searched in EPICS_DB_INCLUDE_PATH (default .) and then in the
+   directory of the including file */
+static FILE *dbDiffOpen(const char *filename, const char *parent, char **path)
+{
+    const char *dir, *end;
+    size_t len;
+    FILE *file = NULL;
+
+    *path = NULL;
+    if (strchr(filename, '/') || strchr(filename, '\\'))
+        return dbDiffOpenIn(NULL, 0, filename, path);
+    dir = getenv("EPICS_DB_INCLUDE_PATH");
+    if (!dir || !*dir) dir = ".";
+    while (1)
+    {
+        end = strchr(dir, OSI_PATH_LIST_SEPARATOR[0]);
+        len = end ? (size_t)(end - dir) : strlen(dir);
+        file = dbDiffOpenIn(dir, len, filename, path);
+        if (file || !end) break;
+        dir = end + 1;
+    }
+    if (!file && parent)
+    {
+        for (len = strlen(parent); len > 0 && parent[len-1] != '/' && parent[len-1] != '\\'; len--);
+        if (len > 0) len--;
+        file = dbDiffOpenIn(parent, len, filename, path);
+    }
+    return file;
+}
+
+static int dbDiffReadFile(struct dbDiffContext *ctx, const char *filename, const char *parent, int depth)
+{
+    struct dbDiffToken *tokens = NULL;
+    size_t ntokens = 0, tokensize = 0;
+    size_t linesize = 256, expandedsize = 256;
+    char *linebuffer, *expandedbuffer, *line;
+    int lineno = 0;
+    int status = 0;
+    char *path;
+    FILE *file;
+
+    if (depth > DBDIFF_MAX_INCLUDE_DEPTH)
+    {
+        fprintf(stderr, "dbDiff: includes nested too deep in %s\n", filename);
+        return -1;
+    }
+    file = dbDiffOpen(filename, parent, &path);
+    if (!file)
+    {
+        fprintf(stderr, "dbDiff: can't open %s: %s\n", filename, strerror(errno));
+        return -1;
+    }
+    linebuffer = malloc(linesize);
+    expandedbuffer = malloc(expandedsize);
+    if (!linebuffer || !expandedbuffer) status = -1;
+    while (!status && (line = dbDiffReadLine(file, &linebuffer, &linesize)) != NULL)
+    {
+        lineno++;
+        line = dbDiffExpand(ctx, line, &expandedbuffer, &expandedsize);
+        status = dbDiffTokenize(ctx, line, lineno, &tokens, &ntokens, &tokensize);
+    }
+    fclose(file);
+    free(linebuffer);
+    free(expandedbuffer);
+    if (status)
+        fprintf(stderr, "dbDiff: out of memory\n");
+    else
+        status = dbDiffParse(ctx, filename, path, depth, tokens, ntokens);
+    free(tokens);
+    free(path);
+    return status;
+}
+
+/* number parsed completely (empty is 0 as for dbPutString), return 0 if not a number */
+static int dbDiffNumber(const char *s, double *value)
+{
+    char *end;
+
+    while (isspace((unsigned char)*s)) s++;
+    if (!*s)
+    {
+        *value = 0;
+        return 1;
+    }
+    if (s[0] == '0' && (s[1] == 'x' || s[1] == 'X'))
+        *value = (double)strtoul(s, &end, 16);
+    else
+        *value = strtod(s, &end);
+    while (isspace((unsigned char)*end)) end++;
+    return end != s && !*end;
+}
+
+/* "X" links to X.VAL */
+static int dbDiffPvNameEqual(const char *a, const char *b)
+{
+    size_t la = strlen(a), lb = strlen(b);
+
+    if (la > lb) return dbDiffPvNameEqual(b, a);
+    if (la == lb) return strcmp(a, b) == 0;
+    return !strchr(a, '.') && lb == la + 4 && strncmp(a, b, la) == 0 && strcmp(b + la, ".VAL") == 0;
+}
+
+static int dbDiffLinkDefault(const char *modifier, int fwdlink)
+{
+    return strcmp(modifier, "NPP") == 0 || strcmp(modifier, "NMS") == 0 ||
+        (fwdlink && strcmp(modifier, "PP") == 0);
+}
+
+/* compare links ignoring default modifiers and a missing .VAL,
+   forward links always process, thus PP does not matter there */
+static int dbDiffLinkEqual(const char *ref, const char *live, int fwdlink)
+{
+    char refbuf[256], livebuf[256];
+    char *reftok[8], *livetok[8];
+    int nref = 0, nlive = 0, i, j;
+    char *p;
+    double a, b;
+
+    if (dbDiffNumber(ref, &a) && dbDiffNumber(live, &b)) return a == b;
+    while (isspace((unsigned char)*ref)) ref++;
+    while (isspace((unsigned char)*live)) live++;
+    if (strchr("@#{", *ref) || strlen(ref) >= sizeof(refbuf) || strlen(live) >= sizeof(livebuf))
+        return strcmp(ref, live) == 0;
+    strcpy(refbuf, ref);
+    strcpy(livebuf, live);
+    for (p = strtok(refbuf, " \t"); p && nref < 8; p = strtok(NULL, " \t"))
+        if (nref == 0 || !dbDiffLinkDefault(p, fwdlink)) reftok[nref++] = p;
+    for (p = strtok(livebuf, " \t"); p && nlive < 8; p = strtok(NULL, " \t"))
+        if (nlive == 0 || !dbDiffLinkDefault(p, fwdlink)) livetok[nlive++] = p;
+    if (nref != nlive) return 0;
+    if (nref == 0) return 1;
+    if (!dbDiffPvNameEqual(reftok[0], livetok[0])) return 0;
+    for (i = 1; i < nref; i++)
+    {
+        for (j = 1; j < nlive; j++)
+            if (strcmp(reftok[i], livetok[j]) == 0) break;
+        if (j == nlive) return 0;
+    }
+    return 1;
+}
+
+/* compare reference value with the field the entry is positioned at */
+static int dbDiffEqual(DBENTRY *pdbEntry, const char *ref, const char *live)
+{
+    dbFldDes *pflddes = pdbEntry->pflddes;
+    void *pfield = pdbEntry->pfield;
+    double value;
+
+    if (!live) live = "";
+    if (strcmp(ref, live) == 0) return 1;
+    switch (pflddes->field_type)
+    {
+        case DBF_STRING:
+            /* too long values are truncated */
+            return strlen(ref) >= (size_t)pflddes->size &&
+                strncmp(ref, live, pflddes->size - 1) == 0;
+        case DBF_INLINK:
+        case DBF_OUTLINK:
+        case DBF_FWDLINK:
+            return dbDiffLinkEqual(ref, live, pflddes->field_type == DBF_FWDLINK);
+        default:
+            break;
+    }
+    if (!pfield || !dbDiffNumber(ref, &value)) return 0;
+    switch (pflddes->field_type)
+    {
+        case DBF_CHAR:   return value == *(epicsInt8 *)pfield;
+        case DBF_UCHAR:  return value == *(epicsUInt8 *)pfield;
+        case DBF_SHORT:  return value == *(epicsInt16 *)pfield;
+        case DBF_USHORT: return value == *(epicsUInt16 *)pfield;
+        case DBF_LONG:   return value == *(epicsInt32 *)pfield;
+        case DBF_ULONG:  return value == *(epicsUInt32 *)pfield;
+        case DBF_FLOAT:  return (epicsFloat32)value == *(epicsFloat32 *)pfield;
+        case DBF_DOUBLE: return value == *(epicsFloat64 *)pfield;
+        case DBF_ENUM:
+        case DBF_MENU:
+        case DBF_DEVICE: return value == *(epicsEnum16 *)pfield;
+        default:         return 0;
+    }
+}
+
+/* dbWalkRecords callback, possibly in parallel worker threads */
+static void dbDiffWalkRecord(DBENTRY *pdbEntry, void *arg)
+{
+    struct dbDiffContext *ctx = arg;
+    struct dbDiffRecord *rec;
+    struct dbDiffField *fld;
+    GPHENTRY *pgph;
+    const char *name, *type, *live;
+    size_t changed = 0;
+
+#ifdef DBRN_FLAGS_ISALIAS
+    if (dbIsAlias(pdbEntry)) return;
+#endif
+    name = dbGetRecordName(pdbEntry);
+    type = dbGetRecordTypeName(pdbEntry);
+    pgph = gphFind(ctx->hash, name, ctx);
+    if (!pgph)
+    {
+        printf("+ %s (%s)\n", name, type);
+        epicsMutexMustLock(ctx->lock);
+        ctx->added++;
+        epicsMutexUnlock(ctx->lock);
+        return;
+    }
+    rec = pgph->userPvt;
+    rec->seen = 1;
+    if (strcmp(rec->type, "*") != 0 && strcmp(rec->type, type) != 0)
+    {
+        printf("~ %s type %s -> %s\n", name, rec->type, type);
+        changed++;
+    }
+    else for (fld = rec->fields; fld; fld = fld->next)
+    {
+        if (dbFindField(pdbEntry, fld->name) != 0)
+        {
+            printf("~ %s.%s \"%s\" -> no such field\n", name, fld->name, fld->value);
+            changed++;
+            continue;
+        }
+        live = dbGetString(pdbEntry);
+        if (dbDiffEqual(pdbEntry, fld->value, live)) continue;
+        printf("~ %s.%s \"%s\" -> \"%s\"\n", name, fld->name, fld->value, live ? live : "");
+        changed++;
+    }
+    epicsMutexMustLock(ctx->lock);
+    ctx->compared++;
+    ctx->changed += changed;
+    epicsMutexUnlock(ctx->lock);
+}
+
+long dbDiff(const char *filename, const char *macros)
+{
+    struct dbDiffContext ctx;
+    struct dbDiffRecord *rec, *next;
+    struct dbDiffField *fld, *nextfld;
+    char **pairs = NULL;
+    size_t i;
+    long status = -1;
+
+    if (!filename || !*filename)
+    {
+        fprintf(stderr, "usage: dbDiff file.db [\"macro=value,...\"]\n");
+        return -1;
+    }
+    if (!pdbbase)
+    {
+        fprintf(stderr, "dbDiff: No database loaded\n");
+        return -1;
+    }
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.lastRecord = &ctx.records;
+    ctx.lock = epicsMutexMustCreate();
+    gphInitPvt(&ctx.hash, 65536);
+    if (macros && *macros)
+    {
+        if (macCreateHandle(&ctx.mac, NULL) != 0 ||
+            macParseDefns(ctx.mac, macros, &pairs) < 0 ||
+            macInstallMacros(ctx.mac, pairs) < 0)
+        {
+            fprintf(stderr, "dbDiff: can't use macros \"%s\"\n", macros);
+            goto end;
+        }
+        macSuppressWarning(ctx.mac, 1);
+    }
+    if (dbDiffReadFile(&ctx, filename, NULL, 0) != 0) goto end;
+
+    dbWalkRecords(dbDiffWalkRecord, &ctx);
+    for (rec = ctx.records; rec; rec = rec->next)
+    {
+        if (rec->seen) continue;
+        printf("- %s (%s)\n", rec->name, rec->type);
+        ctx.removed++;
+    }
+    printf("%lu records compared, %lu added, %lu removed, %lu fields changed\n",
+        (unsigned long)ctx.compared, (unsigned long)ctx.added,
+        (unsigned long)ctx.removed, (unsigned long)ctx.changed);
+    status = ctx.added || ctx.removed || ctx.changed;
+end:
+    for (rec = ctx.records; rec; rec = next)
+    {
+        next = rec->next;
+        for (fld = rec->fields; fld; fld = nextfld)
+        {
+            nextfld = fld->next;
+            free(fld);
+        }
+        free(rec);
+    }
+    for (i = 0; i < ctx.nstrings; i++) free(ctx.strings[i]);
+    free(ctx.strings);
+    free(pairs);
+    if (ctx.mac) macDeleteHandle(ctx.mac);
+    gphFreeMem(ctx.hash);
+    epicsMutexDestroy(ctx.lock);
+    return status;
+}
+
+static const iocshFuncDef dbDiffDef =
+    { "dbDiff", 2, (const iocshArg *[]) {
+    &(iocshArg) { "file.db", iocshArgString },
+    &(iocshArg) { "macros", iocshArgString },
+}};
+
+/*
+    dbDiff: Compare the records of the ioc with a .db file
+
+    Reads the file (with macros like dbLoadRecords) and prints records
+    that exist only in the ioc (+) or only in the file (-) and fields
+    whose value differs from the file (~). Only fields set in the file
+    are compared, aliases and info items are ignored. The file and its
+    includes are searched in EPICS_DB_INCLUDE_PATH (default .), includes
+    also in the directory of the including file.
+    Runs with dbWalkThreads threads if set.
+*/
+
+void dbDiffFunc(const iocshArgBuf *args)
+{
+    dbDiff(args[0].sval, args[1].sval);
+}
+
+static void dbDiffRegistrar(void)
+{
+    iocshRegister(&dbDiffDef, dbDiffFunc);
+}
+
+epicsExportRegistrar(dbDiffRegistrar);
@@ -0,0 +1,417 @@
+/* dbLockSetReport.c
+*
+*  static analysis of lock sets and processing cycles
+*
+* Copyright (C) 2026 Dirk Zimoch
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+#include <stdlib.h>
+#include "epicsVersion.h"
+#include "dbStaticLib.h"
+#include "dbAccess.h"
+#include "dbCommon.h"
+#include "gpHash.h"
+#include "iocsh.h"
+#include "epicsStdioRedirect.h"
+#include "epicsExport.h"
+
+#include "dbll.h"
+
+/*
+    Records form a graph with database links as edges.
+    DB links (not CA links) merge the lock sets of both records. Before
+    3.16, dbLock.c makes an exception for non-PP, non-MS input links from
+    scalar fields, since 3.16 all DB links merge. Thus lock sets are the
+    connected components of that graph (union-find).
+    The element count of the target comes from dbNameToAddr. Before
+    iocInit, record support is not initialized and array fields still
+    report 1 element, so such links are not counted as merging.
+    Processing cycles are strongly connected components (Tarjan) of the
+    directed graph of FLNK, PP input and PP output links to passive records.
+*/
+
+struct lsGraph {
+    struct gphPvt *hash;        /* real record name -> index+1 */
+    const char **names;
+    int nrec;
+    int *parent;                /* union-find */
+    int *size;
+    int *edgeSrc;               /* processing edges */
+    int *edgeDst;
+    size_t nedge, maxedge;
+    long nlinks;
+    const char *lastName;       /* source record cache */
+    int lastIndex;
+    DBENTRY target;
+};
+
+static int lsFind(struct lsGraph *g, int i)
+{
+    while (g->parent[i] != i)
+    {
+        g->parent[i] = g->parent[g->parent[i]];
+        i = g->parent[i];
+    }
+    return i;
+}
+
+static void lsUnion(struct lsGraph *g, int a, int b)
+{
+    a = lsFind(g, a);
+    b = lsFind(g, b);
+    if (a == b) return;
+    if (g->size[a] < g->size[b]) { int t = a; a = b; b = t; }
+    g->parent[b] = a;
+    g->size[a] += g->size[b];
+}
+
+static int lsIndex(struct lsGraph *g, const char *name)
+{
+    GPHENTRY *pgph = gphFind(g->hash, name, g->hash);
+    return pgph ? (int)(size_t)pgph->userPvt - 1 : -1;
+}
+
+/* does the link merge the lock sets? (see dbLockInitRecords) */
+static int lsLinkMerges(DBENTRY *pdbEntry, const DBLINK *link)
+{
+#if EPICS_VERSION*10000+EPICS_REVISION*100+EPICS_MODIFICATION < 31600
+    const char *pvname = link->value.pv_link.pvname;
+    char name[PVNAME_STRINGSZ + 8];
+    size_t len;
+    DBADDR addr;
+
+    if (pdbEntry->pflddes->field_type != DBF_INLINK) return 1;
+    if (link->value.pv_link.pvlMask & (pvlOptPP | pvlOptMS)) return 1;
+    /* element count of the target field */
+    len = strcspn(pvname, " ");
+    if (len >= sizeof(name)) return 1;
+    memcpy(name, pvname, len);
+    name[len] = 0;
+    if (dbNameToAddr(name, &addr) != 0) return 1;
+    return addr.no_elements > 1;
+#else
+    return 1;
+#endif
+}
+
+static void lsAddLink(DBENTRY *pdbEntry, const char *symbol, void *arg)
+{
+    struct lsGraph *g = arg;
+    const DBLINK *link = (DBLINK *)pdbEntry->pfield;
+    const char *pvname = link->value.pv_link.pvname;
+    const char *name = dbGetRecordName(pdbEntry);
+    dbCommon *precord;
+    char key[PVNAME_STRINGSZ];
+    size_t len;
+    int src, dst;
+
+    if (name != g->lastName)
+    {
+        g->lastName = name;
+        g->lastIndex = lsIndex(g, name);
+    }
+    src = g->lastIndex;
+    if (src < 0) return;
+    /* PV links with CA options become CA links */
+    if (link->value.pv_link.pvlMask & (pvlOptCA | pvlOptCP | pvlOptCPP)) return;
+
+    len = strcspn(pvname, ". ");
+    if (len >= sizeof(key)) return;
+    memcpy(key, pvname, len);
+    key[len] = 0;
+    if (dbFindRecord(&g->target, key) != 0) return;
+    precord = (dbCommon *)g->target.precnode->precord;
+    dst = lsIndex(g, precord->name);
+    if (dst < 0) return;
+
+    if (lsLinkMerges(pdbEntry, link))
+    {
+        g->nlinks++;
+        lsUnion(g, src, dst);
+    }
+
+    if (symbol[0] != 'p' && symbol[2] != 'p') return;
+    /* PP and FLNK only process passive records, except output links writing PROC */
+    if (precord->scan != 0 && !(pdbEntry->pflddes->field_type == DBF_OUTLINK
+        && pvname[len] == '.' && strncmp(pvname + len + 1, "PROC", 4) == 0)) return;
+    if (g->nedge == g->maxedge)
+    {
+        size_t n = g->maxedge ? 2 * g->maxedge : 1024;
+        int *s = realloc(g->edgeSrc, n * sizeof(int));
+        int *d = s ? realloc(g->edgeDst, n * sizeof(int)) : NULL;
+        if (s) g->edgeSrc = s;
+        if (!d) return;
+        g->edgeDst = d;
+        g->maxedge = n;
+    }
+    g->edgeSrc[g->nedge] = src;
+    g->edgeDst[g->nedge] = dst;
+    g->nedge++;
+}
+
+static void lsPrintNames(struct lsGraph *g, const int *members, int n)
+{
+    int i, col = 4;
+
+    printf("   ");
+    for (i = 0; i < n; i++)
+    {
+        const char *name = g->names[members[i]];
+        int l = (int)strlen(name);
+        if (col + l > 78 && col > 4)
+        {
+            printf("\n   ");
+            col = 4;
+        }
+        printf(" %s", name);
+        col += l + 1;
+    }
+    printf("\n");
+}
+
+/* Tarjan's algorithm, iterative to survive long chains */
+static int lsFindCycles(struct lsGraph *g, int level)
+{
+    int n = g->nrec;
+    int *start = calloc(n + 1, sizeof(int));
+    int *adj = malloc((g->nedge + 1) * sizeof(int));
+    int *index = malloc(n * sizeof(int));
+    int *low = malloc(n * sizeof(int));
+    int *pos = malloc(n * sizeof(int));
+    int *stack = malloc(n * sizeof(int));
+    int *call = malloc(n * sizeof(int));
+    char *onstack = calloc(n, 1);
+    int sp = 0, cp = 0, next = 0, ncycles = 0, v;
+    size_t e;
+
+    if (!start || !adj || !index || !low || !pos || !stack || !call || !onstack)
+    {
+        fprintf(stderr, "dbLockSetReport: out of memory\n");
+        ncycles = -1;
+        goto end;
+    }
+
+    /* compressed adjacency lists */
+    for (e = 0; e < g->nedge; e++) start[g->edgeSrc[e] + 1]++;
+    for (v = 0; v < n; v++) start[v + 1] += start[v];
+    memcpy(pos, start, n * sizeof(int));
+    for (e = 0; e < g->nedge; e++) adj[pos[g->edgeSrc[e]]++] = g->edgeDst[e];
+    for (v = 0; v < n; v++) index[v] = -1;
+
+    for (v = 0; v < n; v++)
+    {
+        if (index[v] >= 0 || start[v] == start[v + 1]) continue;
+        index[v] = low[v] = next++;
+        pos[v] = start[v];
+        stack[sp++] = v;
+        onstack[v] = 1;
+        call[cp++] = v;
+        while (cp)
+        {
+            int u = call[cp - 1];
+            if (pos[u] < start[u + 1])
+            {
+                int w = adj[pos[u]++];
+                if (index[w] < 0)
+                {
+                    index[w] = low[w] = next++;
+                    pos[w] = start[w];
+                    stack[sp++] = w;
+                    onstack[w] = 1;
+                    call[cp++] = w;
+                }
+                else if (onstack[w] && index[w] < low[u])
+                    low[u] = index[w];
+                continue;
+            }
+            cp--;
+            if (cp && low[u] < low[call[cp - 1]]) low[call[cp - 1]] = low[u];
+            if (low[u] == index[u])
+            {
+                int first = sp, self = 0, i;
+                do onstack[stack[--first]] = 0; while (stack[first] != u);
+                for (i = start[u]; i < start[u + 1]; i++)
+                    if (adj[i] == u) self = 1;
+                if (sp - first > 1 || self)
+                {
+                    ncycles++;
+                    printf("  processing cycle of %d record%s: %s\n",
+                        sp - first, sp - first > 1 ? "s" : "", g->names[u]);
+                    if (level > 0) lsPrintNames(g, stack + first, sp - first);
+                }
+                sp = first;
+            }
+        }
+    }
+end:
+    free(start);
+    free(adj);
+    free(index);
+    free(low);
+    free(pos);
+    free(stack);
+    free(call);
+    free(onstack);
+    return ncycles;
+}
+
+static struct lsGraph *lsSortGraph;
+
+static int lsCompareRoots(const void *a, const void *b)
+{
+    return lsSortGraph->size[*(const int *)b] - lsSortGraph->size[*(const int *)a];
+}
+
+long dbLockSetReport(int count, int level)
+{
+    struct lsGraph g;
+    DBENTRY dbEntry;
+    long status;
+    int i, nsets = 0, nsingle = 0, nroots = 0, ncycles;
+    int *roots = NULL;
+    int *members = NULL;
+
+    if (!pdbbase)
+    {
+        fprintf(stderr, "dbLockSetReport: no database loaded\n");
+        return -1;
+    }
+    if (count <= 0) count = 10;
+    memset(&g, 0, sizeof(g));
+    gphInitPvt(&g.hash, 65536);
+
+    /* number all records */
+    dbInitEntry(pdbbase, &dbEntry);
+    for (status = dbFirstRecordType(&dbEntry); !status; status = dbNextRecordType(&dbEntry))
+        g.nrec += dbGetNRecords(&dbEntry);
+    g.names = malloc((g.nrec + 1) * sizeof(char *));
+    g.parent = malloc((g.nrec + 1) * sizeof(int));
+    g.size = malloc((g.nrec + 1) * sizeof(int));
+    if (!g.names || !g.parent || !g.size)
+    {
+        fprintf(stderr, "dbLockSetReport: out of memory\n");
+        goto end;
+    }
+    i = 0;
+    for (status = dbFirstRecordType(&dbEntry); !status; status = dbNextRecordType(&dbEntry))
+    for (status = dbFirstRecord(&dbEntry); !status && i < g.nrec; status = dbNextRecord(&dbEntry))
+    {
+        GPHENTRY *pgph;
+
+        #ifdef DBRN_FLAGS_ISALIAS
+        if (dbIsAlias(&dbEntry)) continue;
+        #endif
+        g.names[i] = ((dbCommon *)dbEntry.precnode->precord)->name;
+        pgph = gphAdd(g.hash, g.names[i], g.hash);
+        if (!pgph) continue;
+        pgph->userPvt = (void *)(size_t)(i + 1);
+        g.parent[i] = i;
+        g.size[i] = 1;
+        i++;
+    }
+    dbFinishEntry(&dbEntry);
+    g.nrec = i;
+
+    /* follow the database links */
+    dbInitEntry(pdbbase, &g.target);
+    dbllForEachLink(DBLL_IMASK|DBLL_OMASK|DBLL_FMASK|DBLL_DMASK, lsAddLink, &g);
+    dbFinishEntry(&g.target);
+
+    /* lock sets */
+    roots = malloc((g.nrec + 1) * sizeof(int));
+    members = malloc((g.nrec + 1) * sizeof(int));
+    if (!roots || !members)
+    {
+        fprintf(stderr, "dbLockSetReport: out of memory\n");
+        goto end;
+    }
+    for (i = 0; i < g.nrec; i++)
+    {
+        if (lsFind(&g, i) != i) continue;
+        nsets++;
+        if (g.size[i] == 1) nsingle++;
+        else roots[nroots++] = i;
+    }
+    printf("%d records, %ld lock set merging links, %d lock sets (%d single record)\n",
+        g.nrec, g.nlinks, nsets, nsingle);
+#if EPICS_VERSION*10000+EPICS_REVISION*100+EPICS_MODIFICATION < 31600
+    if (!interruptAccept)
+        printf("before iocInit: input links from array fields are counted as not merging\n");
+#endif
+
+    lsSortGraph = &g;
+    qsort(roots, nroots, sizeof(int), lsCompareRoots);
+    if (nroots)
+        printf("biggest lock sets:\n");
+    for (i = 0; i < nroots && i < count; i++)
+    {
+        int j, n = 0;
+        for (j = 0; j < g.nrec; j++)
+            if (lsFind(&g, j) == roots[i]) members[n++] = j;
+        printf("  lock set of %d records: %s\n", n, g.names[members[0]]);
+        if (level > 0) lsPrintNames(&g, members, n);
+    }
+
+    /* processing cycles */
+    printf("%lu processing links\n", (unsigned long)g.nedge);
+    ncycles = lsFindCycles(&g, level);
+    if (ncycles >= 0)
+        printf("%d processing cycle%s\n", ncycles, ncycles == 1 ? "" : "s");
+
+end:
+    free(roots);
+    free(members);
+    free(g.names);
+    free(g.parent);
+    free(g.size);
+    free(g.edgeSrc);
+    free(g.edgeDst);
+    gphFreeMem(g.hash);
+    return 0;
+}
+
+static const iocshFuncDef dbLockSetReportDef =
+    { "dbLockSetReport", 2, (const iocshArg *[]) {
+    &(iocshArg) { "number of lock sets to show", iocshArgInt },
+    &(iocshArg) { "level", iocshArgInt },
+}};
+
+/*
+    dbLockSetReport: Show lock sets and processing cycles of the database
+
+    Groups records into the lock sets built from database links at iocInit
+    and lists the biggest ones. Before iocInit, input links from arrays
+    may be missed (EPICS before 3.16), run it after iocInit for exact
+    lock sets. Records of one lock set are processed
+    serialized, no matter which scan or callback thread processes them.
+    Then finds processing cycles along FLNK, PP input and PP output links.
+
+    Number of lock sets to show: default 10
+    Level > 0: list all member records of the shown lock sets and cycles
+*/
+
+void dbLockSetReportFunc(const iocshArgBuf *args)
+{
+    dbLockSetReport(args[0].ival, args[1].ival);
+}
+
+static void dbLockSetReportRegistrar(void)
+{
+    iocshRegister(&dbLockSetReportDef, dbLockSetReportFunc);
+}
+
+epicsExportRegistrar(dbLockSetReportRegistrar);
@@ -0,0 +1,567 @@
+/* dbSnapshot.c
+*
+*  write field values of all records into a binary file that can be mapped
+*
+* Copyright (C) 2026 Dirk Zimoch
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include "dbStaticLib.h"
+#include "dbAccess.h"
+#include "epicsTypes.h"
+#include "epicsTime.h"
+#include "epicsString.h"
+#include "gpHash.h"
+#include "epicsStdioRedirect.h"
+#include "iocsh.h"
+#include "epicsExport.h"
+
+#include "globMatch.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define DBSNAPSHOT_MMAP
+#endif
+
+/*
+    File layout, all numbers 32 bit in the byte order of the writer:
+    header
+    field names: nfields string offsets
+    index:       nrecords entries of record name, record type and
+                 nfields value offsets, sorted by record name
+    pool:        NUL terminated strings
+    String offsets are relative to the pool, DBSNAPSHOT_NONE if the
+    record has no such field. Equal values are stored only once.
+    The pool is built in blocks of DBSNAPSHOT_BLOCK bytes which are
+    written completely, so strings never move while building.
+    The file is written to a temporary name and renamed, so readers
+    never see a partial snapshot.
+*/
+
+#define DBSNAPSHOT_MAGIC "dbSnap1"
+#define DBSNAPSHOT_BYTEORDER 0x01020304
+#define DBSNAPSHOT_NONE 0xffffffff
+#define DBSNAPSHOT_BLOCK (1<<20)
+#define DBSNAPSHOT_MAX_FIELDS 64
+#define DBSNAPSHOT_DEFAULT_FIELDS "VAL STAT SEVR"
+
+struct dbSnapshotHeader {
+    char magic[8];
+    epicsUInt32 byteOrder;
+    epicsUInt32 nrecords;
+    epicsUInt32 nfields;
+    epicsUInt32 secPastEpoch;
+    epicsUInt32 nsec;
+    epicsUInt32 fieldsOffset;
+    epicsUInt32 indexOffset;
+    epicsUInt32 poolOffset;
+    epicsUInt32 poolSize;
+};
+
+struct dbSnapshotPool {
+    char **blocks;
+    size_t nblocks;
+    size_t used;                    /* in last block */
+    struct gphPvt *hash;
+};
+
+static const char *dbSnapshotString(struct dbSnapshotPool *pool, epicsUInt32 offset)
+{
+    return pool->blocks[offset / DBSNAPSHOT_BLOCK] + offset % DBSNAPSHOT_BLOCK;
+}
+
+/* returns offset of a copy of the string in the pool or DBSNAPSHOT_NONE */
+static epicsUInt32 dbSnapshotAdd(struct dbSnapshotPool *pool, const char *s, int unique)
+{
+    size_t len = strlen(s) + 1;
+    GPHENTRY *pgph = NULL;
+    epicsUInt32 offset;
+    char *copy;
+
+    if (len > DBSNAPSHOT_BLOCK) return DBSNAPSHOT_NONE;
+    if (!unique)
+    {
+        pgph = gphFind(pool->hash, s, pool);
+        if (pgph) return (epicsUInt32)(size_t)pgph->userPvt;
+    }
+    if (pool->nblocks == 0 || pool->used + len > DBSNAPSHOT_BLOCK)
+    {
+        char **blocks;
+
+        if ((pool->nblocks + 1) * (double)DBSNAPSHOT_BLOCK >= DBSNAPSHOT_NONE)
+            return DBSNAPSHOT_NONE;
+        blocks = realloc(pool->blocks, (pool->nblocks + 1) * sizeof(char *));
+        if (!blocks) return DBSNAPSHOT_NONE;
+        pool->blocks = blocks;
+        pool->blocks[pool->nblocks] = calloc(1, DBSNAPSHOT_BLOCK);
+        if (!pool->blocks[pool->nblocks]) return DBSNAPSHOT_NONE;
+        pool->nblocks++;
+        pool->used = 0;
+    }
+    offset = (epicsUInt32)((pool->nblocks - 1) * DBSNAPSHOT_BLOCK + pool->used);
+    copy = pool->blocks[pool->nblocks - 1] + pool->used;
+    memcpy(copy, s, len);
+    pool->used += len;
+    if (!unique)
+    {
+        pgph = gphAdd(pool->hash, copy, pool);
+        if (pgph) pgph->userPvt = (void *)(size_t)offset;
+    }
+    return offset;
+}
+
+/* the index is sorted as (record name, entry) pairs, no globals for qsort */
+struct dbSnapshotSortItem {
+    const char *name;
+    const epicsUInt32 *entry;
+};
+
+static int dbSnapshotCompare(const void *a, const void *b)
+{
+    return strcmp(((const struct dbSnapshotSortItem *)a)->name,
+        ((const struct dbSnapshotSortItem *)b)->name);
+}
+
+/* copy of the index sorted by record name */
+static epicsUInt32 *dbSnapshotSort(const epicsUInt32 *index, size_t nrecords, size_t entrySize,
+    struct dbSnapshotPool *pool)
+{
+    struct dbSnapshotSortItem *items;
+    epicsUInt32 *sorted;
+    size_t i;
+
+    items = malloc((nrecords + 1) * sizeof(struct dbSnapshotSortItem));
+    sorted = malloc(nrecords * entrySize + 1);
+    if (!items || !sorted)
+    {
+        free(items);
+        free(sorted);
+        return NULL;
+    }
+    for (i = 0; i < nrecords; i++)
+    {
+        items[i].entry = (const epicsUInt32 *)((const char *)index + i * entrySize);
+        items[i].name = dbSnapshotString(pool, items[i].entry[0]);
+    }
+    qsort(items, nrecords, sizeof(struct dbSnapshotSortItem), dbSnapshotCompare);
+    for (i = 0; i < nrecords; i++)
+        memcpy((char *)sorted + i * entrySize, items[i].entry, entrySize);
+    free(items);
+    return sorted;
+}
+
+static int dbSnapshotWrite(const char *filename, struct dbSnapshotHeader *header,
+    const epicsUInt32 *fields, const epicsUInt32 *index, size_t entrySize,
+    struct dbSnapshotPool *pool)
+{
+    char *tmpname;
+    FILE *file;
+    size_t i;
+    int status = 0;
+
+    tmpname = malloc(strlen(filename) + 5);
+    if (!tmpname) return ENOMEM;
+    sprintf(tmpname, "%s.tmp", filename);
+    file = fopen(tmpname, "wb");
+    if (!file)
+    {
+        status = errno;
+        free(tmpname);
+        return status;
+    }
+    if (fwrite(header, sizeof(*header), 1, file) != 1
+        || fwrite(fields, sizeof(epicsUInt32), header->nfields, file) != header->nfields
+        || fwrite(index, entrySize, header->nrecords, file) != header->nrecords)
+        status = errno;
+    for (i = 0; !status && i < pool->nblocks; i++)
+        if (fwrite(pool->blocks[i], i + 1 < pool->nblocks ? DBSNAPSHOT_BLOCK : pool->used, 1, file) != 1)
+            status = errno;
+    if (fclose(file) != 0 && !status) status = errno;
+    if (!status)
+    {
+#ifdef _WIN32
+        remove(filename);
+#endif
+        if (rename(tmpname, filename) != 0) status = errno;
+    }
+    if (status) remove(tmpname);
+    free(tmpname);
+    return status;
+}
+
+long dbSnapshot(const char *filename, const char *fieldlist)
+{
+    struct dbSnapshotHeader header;
+    struct dbSnapshotPool pool;
+    epicsUInt32 fields[DBSNAPSHOT_MAX_FIELDS];
+    char *fieldnames[DBSNAPSHOT_MAX_FIELDS];
+    char *fieldbuffer, *p;
+    epicsUInt32 *index = NULL, *sorted = NULL, *entry;
+    size_t nrecords = 0, size = 0, entrySize, i;
+    epicsTimeStamp start, end;
+    DBENTRY dbEntry;
+    long status;
+
+    if (!filename || !*filename)
+    {
+        fprintf(stderr, "usage: dbSnapshot file [\"field ...\"]\n");
+        return -1;
+    }
+    if (!pdbbase)
+    {
+        fprintf(stderr, "dbSnapshot: No database loaded\n");
+        return -1;
+    }
+    epicsTimeGetCurrent(&start);
+    memset(&header, 0, sizeof(header));
+    memset(&pool, 0, sizeof(pool));
+    gphInitPvt(&pool.hash, 65536);
+
+    /* fields separated by space or comma, as for dbl */
+    fieldbuffer = epicsStrDup(fieldlist && *fieldlist ? fieldlist : DBSNAPSHOT_DEFAULT_FIELDS);
+    for (p = strtok(fieldbuffer, " ,"); p; p = strtok(NULL, " ,"))
+    {
+        if (header.nfields == DBSNAPSHOT_MAX_FIELDS)
+        {
+            fprintf(stderr, "dbSnapshot: only %d fields supported\n", DBSNAPSHOT_MAX_FIELDS);
+            break;
+        }
+        fieldnames[header.nfields] = p;
+        fields[header.nfields++] = dbSnapshotAdd(&pool, p, 0);
+    }
+    entrySize = (2 + header.nfields) * sizeof(epicsUInt32);
+
+    dbInitEntry(pdbbase, &dbEntry);
+    for (status = dbFirstRecordType(&dbEntry); !status; status = dbNextRecordType(&dbEntry))
+    {
+        epicsUInt32 rtyp = dbSnapshotAdd(&pool, dbGetRecordTypeName(&dbEntry), 0);
+
+        for (status = dbFirstRecord(&dbEntry); !status; status = dbNextRecord(&dbEntry))
+        {
+#ifdef DBRN_FLAGS_ISALIAS
+            if (dbIsAlias(&dbEntry)) continue;
+#endif
+            if (nrecords == size)
+            {
+                epicsUInt32 *newindex;
+
+                size = size ? size * 2 : 4096;
+                newindex = realloc(index, size * entrySize);
+                if (!newindex)
+                {
+                    fprintf(stderr, "dbSnapshot: out of memory\n");
+                    status = -1;
+                    goto end;
+                }
+                index = newindex;
+            }
+            entry = (epicsUInt32 *)((char *)index + nrecords++ * entrySize);
+            entry[0] = dbSnapshotAdd(&pool, dbGetRecordName(&dbEntry), 1);
+            entry[1] = rtyp;
+            for (i = 0; i < header.nfields; i++)
+            {
+                const char *value;
+
+                entry[2+i] = DBSNAPSHOT_NONE;
+                if (dbFindField(&dbEntry, fieldnames[i]) != 0) continue;
+                value = dbGetString(&dbEntry);
+                if (value) entry[2+i] = dbSnapshotAdd(&pool, value, 0);
+            }
+            if (entry[0] == DBSNAPSHOT_NONE)
+            {
+                fprintf(stderr, "dbSnapshot: out of memory\n");
+                status = -1;
+                goto end;
+            }
+        }
+    }
+
+    sorted = dbSnapshotSort(index, nrecords, entrySize, &pool);
+    if (!sorted)
+    {
+        fprintf(stderr, "dbSnapshot: out of memory\n");
+        status = -1;
+        goto end;
+    }
+
+    strcpy(header.magic, DBSNAPSHOT_MAGIC);
+    header.byteOrder = DBSNAPSHOT_BYTEORDER;
+    header.nrecords = (epicsUInt32)nrecords;
+    header.secPastEpoch = start.secPastEpoch;
+    header.nsec = start.nsec;
+    header.fieldsOffset = sizeof(header);
+    header.indexOffset = header.fieldsOffset + header.nfields * sizeof(epicsUInt32);
+    header.poolOffset = (epicsUInt32)(header.indexOffset + nrecords * entrySize);
+    header.poolSize = pool.nblocks ? (epicsUInt32)((pool.nblocks - 1) * DBSNAPSHOT_BLOCK + pool.used) : 0;
+    status = dbSnapshotWrite(filename, &header, fields, sorted, entrySize, &pool);
+    if (status)
+    {
+        fprintf(stderr, "dbSnapshot: can't write %s: %s\n", filename, strerror(status));
+        goto end;
+    }
+    epicsTimeGetCurrent(&end);
+    printf("%lu records with %u fields written to %s (%lu bytes) in %.2f s\n",
+        (unsigned long)nrecords, header.nfields, filename,
+        (unsigned long)(header.poolOffset + header.poolSize),
+        epicsTimeDiffInSeconds(&end, &start));
+end:
+    dbFinishEntry(&dbEntry);
+    for (i = 0; i < pool.nblocks; i++) free(pool.blocks[i]);
+    free(pool.blocks);
+    gphFreeMem(pool.hash);
+    free(index);
+    free(sorted);
+    free(fieldbuffer);
+    return status;
+}
+
+/*
+    Reading: the file is mapped (or read where mmap is not available)
+    and only the index entries needed are looked at.
+*/
+
+struct dbSnapshotFile {
+    char *data;
+    size_t size;
+    const struct dbSnapshotHeader *header;
+    const epicsUInt32 *fields;
+    const char *index;
+    size_t entrySize;
+    const char *pool;
+};
+
+static const char *dbSnapshotFileString(const struct dbSnapshotFile *snap, epicsUInt32 offset)
+{
+    if (offset >= snap->header->poolSize) return NULL;
+    return snap->pool + offset;
+}
+
+static int dbSnapshotOpen(const char *filename, struct dbSnapshotFile *snap)
+{
+    const struct dbSnapshotHeader *header;
+#ifdef DBSNAPSHOT_MMAP
+    struct stat st;
+    int fd;
+#else
+    FILE *file;
+    long size;
+#endif
+
+    memset(snap, 0, sizeof(*snap));
+#ifdef DBSNAPSHOT_MMAP
+    fd = open(filename, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+        fprintf(stderr, "dbSnapshotShow: can't open %s: %s\n", filename, strerror(errno));
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    snap->size = st.st_size;
+    if (snap->size >= sizeof(struct dbSnapshotHeader))
+        snap->data = mmap(NULL, snap->size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (snap->data == MAP_FAILED) snap->data = NULL;
+#else
+    file = fopen(filename, "rb");
+    if (!file)
+    {
+        fprintf(stderr, "dbSnapshotShow: can't open %s: %s\n", filename, strerror(errno));
+        return -1;
+    }
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size >= (long)sizeof(struct dbSnapshotHeader))
+    {
+        snap->size = size;
+        snap->data = malloc(snap->size);
+        if (snap->data && fread(snap->data, snap->size, 1, file) != 1)
+        {
+            free(snap->data);
+            snap->data = NULL;
+        }
+    }
+    fclose(file);
+#endif
+    if (!snap->data)
+    {
+        fprintf(stderr, "dbSnapshotShow: can't read %s\n", filename);
+        return -1;
+    }
+    header = snap->header = (const struct dbSnapshotHeader *)snap->data;
+    snap->entrySize = (2 + header->nfields) * sizeof(epicsUInt32);
+    if (memcmp(header->magic, DBSNAPSHOT_MAGIC, sizeof(DBSNAPSHOT_MAGIC)) != 0
+        || header->byteOrder != DBSNAPSHOT_BYTEORDER
+        || header->fieldsOffset != sizeof(struct dbSnapshotHeader)
+        || header->indexOffset != header->fieldsOffset + header->nfields * sizeof(epicsUInt32)
+        || header->poolOffset != header->indexOffset + header->nrecords * snap->entrySize
+        || header->poolOffset + (double)header->poolSize > snap->size
+        /* strings in the pool must not run past its end */
+        || (header->poolSize && snap->data[header->poolOffset + header->poolSize - 1] != 0))
+    {
+        fprintf(stderr, "dbSnapshotShow: %s is not a snapshot of this architecture\n", filename);
+        return -1;
+    }
+    snap->fields = (const epicsUInt32 *)(snap->data + header->fieldsOffset);
+    snap->index = snap->data + header->indexOffset;
+    snap->pool = snap->data + header->poolOffset;
+    return 0;
+}
+
+static void dbSnapshotClose(struct dbSnapshotFile *snap)
+{
+    if (!snap->data) return;
+#ifdef DBSNAPSHOT_MMAP
+    munmap(snap->data, snap->size);
+#else
+    free(snap->data);
+#endif
+    snap->data = NULL;
+}
+
+static void dbSnapshotPrint(const struct dbSnapshotFile *snap, const epicsUInt32 *entry)
+{
+    const char *name = dbSnapshotFileString(snap, entry[0]);
+    const char *rtyp = dbSnapshotFileString(snap, entry[1]);
+    epicsUInt32 i;
+
+    printf("%s (%s)", name ? name : "?", rtyp ? rtyp : "?");
+    for (i = 0; i < snap->header->nfields; i++)
+    {
+        const char *field = dbSnapshotFileString(snap, snap->fields[i]);
+        const char *value = dbSnapshotFileString(snap, entry[2+i]);
+        if (field && value) printf(" %s=\"%s\"", field, value);
+    }
+    printf("\n");
+}
+
+long dbSnapshotShow(const char *filename, const char *pattern)
+{
+    struct dbSnapshotFile snap;
+    epicsTimeStamp stamp;
+    char timestr[40];
+    epicsUInt32 i;
+
+    if (!filename || !*filename)
+    {
+        fprintf(stderr, "usage: dbSnapshotShow file [record_name_pattern]\n");
+        return -1;
+    }
+    if (dbSnapshotOpen(filename, &snap) != 0)
+    {
+        dbSnapshotClose(&snap);
+        return -1;
+    }
+    if (!pattern || !*pattern)
+    {
+        stamp.secPastEpoch = snap.header->secPastEpoch;
+        stamp.nsec = snap.header->nsec;
+        epicsTimeToStrftime(timestr, sizeof(timestr), "%Y-%m-%d %H:%M:%S.%03f", &stamp);
+        printf("%u records from %s, fields:", snap.header->nrecords, timestr);
+        for (i = 0; i < snap.header->nfields; i++)
+        {
+            const char *field = dbSnapshotFileString(&snap, snap.fields[i]);
+            printf(" %s", field ? field : "?");
+        }
+        printf("\n");
+    }
+    else if (!strpbrk(pattern, "*?"))
+    {
+        /* binary search in the sorted index */
+        size_t lo = 0, hi = snap.header->nrecords;
+        while (lo < hi)
+        {
+            size_t mid = lo + (hi - lo) / 2;
+            const epicsUInt32 *entry = (const epicsUInt32 *)(snap.index + mid * snap.entrySize);
+            const char *name = dbSnapshotFileString(&snap, entry[0]);
+            int cmp = name ? strcmp(pattern, name) : -1;
+            if (cmp == 0)
+            {
+                dbSnapshotPrint(&snap, entry);
+                break;
+            }
+            if (cmp < 0) hi = mid;
+            else lo = mid + 1;
+        }
+    }
+    else
+    {
+        globMatcher *matcher = globCompile(pattern);
+        for (i = 0; i < snap.header->nrecords; i++)
+        {
+            const epicsUInt32 *entry = (const epicsUInt32 *)(snap.index + i * snap.entrySize);
+            const char *name = dbSnapshotFileString(&snap, entry[0]);
+            if (name && globMatch(matcher, name)) dbSnapshotPrint(&snap, entry);
+        }
+        globFree(matcher);
+    }
+    dbSnapshotClose(&snap);
+    return 0;
+}
+
+static const iocshFuncDef dbSnapshotDef =
+    { "dbSnapshot", 2, (const iocshArg *[]) {
+    &(iocshArg) { "file", iocshArgString },
+    &(iocshArg) { "fields", iocshArgString },
+}};
+
+/*
+    dbSnapshot: Write field values of all records to a binary file
+
+    Writes the values of the given fields (default "VAL STAT SEVR",
+    separated by space or comma) of every record as strings into a
+    compact file with a sorted name index. Equal values are stored
+    only once. Use dbSnapshotShow to look at it, on this or on
+    another computer of the same architecture.
+*/
+
+void dbSnapshotFunc(const iocshArgBuf *args)
+{
+    dbSnapshot(args[0].sval, args[1].sval);
+}
+
+static const iocshFuncDef dbSnapshotShowDef =
+    { "dbSnapshotShow", 2, (const iocshArg *[]) {
+    &(iocshArg) { "file", iocshArgString },
+    &(iocshArg) { "record name pattern", iocshArgString },
+}};
+
+/*
+    dbSnapshotShow: Show records from a snapshot file
+
+    Maps the file written by dbSnapshot and prints the records matching
+    the pattern. A record name without wildcards is found by binary
+    search. Without pattern, only time and fields of the snapshot are
+    shown.
+*/
+
+void dbSnapshotShowFunc(const iocshArgBuf *args)
+{
+    dbSnapshotShow(args[0].sval, args[1].sval);
+}
+
+static void dbSnapshotRegistrar(void)
+{
+    iocshRegister(&dbSnapshotDef, dbSnapshotFunc);
+    iocshRegister(&dbSnapshotShowDef, dbSnapshotShowFunc);
+}
+
+epicsExportRegistrar(dbSnapshotRegistrar);
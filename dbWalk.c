@@ -0,0 +1,232 @@
+/* dbWalk.c
+*
+*  walk all records of the database with worker threads
+*
+* Copyright (C) 2026 Dirk Zimoch
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "dbStaticLib.h"
+#include "dbAccess.h"
+#include "epicsThread.h"
+#include "epicsMutex.h"
+#include "epicsEvent.h"
+#include "epicsStdioRedirect.h"
+#include "epicsExport.h"
+
+#include "dbWalk.h"
+
+int dbWalkThreads = 0;
+epicsExportAddress(int, dbWalkThreads);
+
+#define DBWALK_CHUNK 2048
+
+/*
+    The main thread splits the record lists into chunks of records of
+    the same type, identified by the name of the first record. Each worker
+    positions its own DBENTRY with dbFindRecord and redirects its stdout
+    to a memory stream. The main thread prints the chunk buffers in order
+    as soon as they are complete, so output starts before the walk ends.
+*/
+
+struct dbWalkChunk {
+    const char *first;
+    int count;
+    int done;
+    char *output;
+    size_t size;
+};
+
+struct dbWalkJob {
+    dbWalkFunc func;
+    void *arg;
+    struct dbWalkChunk *chunks;
+    int nchunks;
+    int next;                   /* next chunk to process */
+    int running;                /* workers still running */
+    epicsMutexId lock;
+    epicsEventId progress;
+};
+
+static long dbWalkSerial(dbWalkFunc func, void *arg)
+{
+    DBENTRY dbEntry;
+    long status;
+
+    dbInitEntry(pdbbase, &dbEntry);
+    for (status = dbFirstRecordType(&dbEntry); !status; status = dbNextRecordType(&dbEntry))
+    for (status = dbFirstRecord(&dbEntry); !status; status = dbNextRecord(&dbEntry))
+        func(&dbEntry, arg);
+    dbFinishEntry(&dbEntry);
+    return 0;
+}
+
+#ifdef __linux__
+static void dbWalkWorker(void *p)
+{
+    struct dbWalkJob *job = p;
+    DBENTRY dbEntry;
+    FILE *oldStdout = epicsGetThreadStdout();
+
+    dbInitEntry(pdbbase, &dbEntry);
+    while (1)
+    {
+        struct dbWalkChunk *chunk;
+        FILE *buffer;
+        int i;
+        long status;
+
+        epicsMutexMustLock(job->lock);
+        i = job->next++;
+        epicsMutexUnlock(job->lock);
+        if (i >= job->nchunks) break;
+        chunk = &job->chunks[i];
+
+        buffer = open_memstream(&chunk->output, &chunk->size);
+        if (buffer) epicsSetThreadStdout(buffer);
+        status = dbFindRecord(&dbEntry, chunk->first);
+        for (i = 0; !status && i < chunk->count; i++)
+        {
+            job->func(&dbEntry, job->arg);
+            status = dbNextRecord(&dbEntry);
+        }
+        if (buffer)
+        {
+            epicsSetThreadStdout(oldStdout);
+            fclose(buffer);
+        }
+
+        epicsMutexMustLock(job->lock);
+        chunk->done = 1;
+        epicsMutexUnlock(job->lock);
+        epicsEventSignal(job->progress);
+    }
+    dbFinishEntry(&dbEntry);
+    epicsMutexMustLock(job->lock);
+    job->running--;
+    epicsMutexUnlock(job->lock);
+    epicsEventSignal(job->progress);
+}
+
+static long dbWalkParallel(dbWalkFunc func, void *arg, int nthreads)
+{
+    struct dbWalkJob job;
+    DBENTRY dbEntry;
+    long status;
+    int n = 0, i, done;
+
+    memset(&job, 0, sizeof(job));
+    job.func = func;
+    job.arg = arg;
+
+    /* split record lists into chunks */
+    dbInitEntry(pdbbase, &dbEntry);
+    for (status = dbFirstRecordType(&dbEntry); !status; status = dbNextRecordType(&dbEntry))
+        n += (dbGetNRecords(&dbEntry) + DBWALK_CHUNK - 1) / DBWALK_CHUNK;
+    job.chunks = calloc(n + 1, sizeof(struct dbWalkChunk));
+    if (!job.chunks)
+    {
+        dbFinishEntry(&dbEntry);
+        return dbWalkSerial(func, arg);
+    }
+    for (status = dbFirstRecordType(&dbEntry); !status; status = dbNextRecordType(&dbEntry))
+    {
+        int count = 0;
+        for (status = dbFirstRecord(&dbEntry); !status; status = dbNextRecord(&dbEntry))
+        {
+            if (count == 0)
+            {
+                if (job.nchunks == n) break;
+                job.chunks[job.nchunks++].first = dbGetRecordName(&dbEntry);
+            }
+            job.chunks[job.nchunks-1].count = ++count;
+            if (count == DBWALK_CHUNK) count = 0;
+        }
+    }
+    dbFinishEntry(&dbEntry);
+
+    job.lock = epicsMutexMustCreate();
+    job.progress = epicsEventMustCreate(epicsEventEmpty);
+    if (nthreads > job.nchunks) nthreads = job.nchunks;
+    job.running = nthreads;
+    for (i = 0; i < nthreads; i++)
+    {
+        char name[16];
+        sprintf(name, "dbWalk%d", i);
+        if (!epicsThreadCreate(name, epicsThreadGetPrioritySelf(),
+            epicsThreadGetStackSize(epicsThreadStackMedium), dbWalkWorker, &job))
+        {
+            epicsMutexMustLock(job.lock);
+            job.running--;
+            epicsMutexUnlock(job.lock);
+        }
+    }
+    if (nthreads > 0)
+    {
+        epicsMutexMustLock(job.lock);
+        done = job.running == 0 && job.next == 0;
+        if (done) job.running = 1;
+        epicsMutexUnlock(job.lock);
+        /* no thread could be created: do it myself */
+        if (done) dbWalkWorker(&job);
+    }
+
+    /* print chunks in order */
+    for (i = 0; i < job.nchunks; i++)
+    {
+        while (1)
+        {
+            epicsMutexMustLock(job.lock);
+            done = job.chunks[i].done;
+            epicsMutexUnlock(job.lock);
+            if (done) break;
+            epicsEventMustWait(job.progress);
+        }
+        if (job.chunks[i].output)
+        {
+            fwrite(job.chunks[i].output, 1, job.chunks[i].size, stdout);
+            free(job.chunks[i].output);
+        }
+    }
+    while (1)
+    {
+        epicsMutexMustLock(job.lock);
+        done = job.running == 0;
+        epicsMutexUnlock(job.lock);
+        if (done) break;
+        epicsEventMustWait(job.progress);
+    }
+    epicsEventDestroy(job.progress);
+    epicsMutexDestroy(job.lock);
+    free(job.chunks);
+    return 0;
+}
+#endif
+
+long dbWalkRecords(dbWalkFunc func, void *arg)
+{
+    if (!pdbbase) return -1;
+#ifdef __linux__
+    if (dbWalkThreads > 1)
+        return dbWalkParallel(func, arg, dbWalkThreads);
+#endif
+    return dbWalkSerial(func, arg);
+}
@@ -0,0 +1,26 @@
+#ifndef dbWalk_h
+#define dbWalk_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "dbStaticLib.h"
+
+/* Call func for every record (and alias) of the database with the entry
+   positioned at the record. With dbWalkThreads > 1 the records are split
+   into chunks processed by that many worker threads. Anything func prints
+   to stdout is collected per chunk and printed in database order, thus the
+   output is the same as in a serial walk. func must be thread safe then. */
+
+typedef void (*dbWalkFunc)(DBENTRY *pdbEntry, void *arg);
+
+long dbWalkRecords(dbWalkFunc func, void *arg);
+
+extern int dbWalkThreads;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
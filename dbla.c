@@ -17,59 +17,238 @@
 * in file LICENSE that is included with this distribution.
 \*************************************************************************/
 
+#include <string.h>
+#include <stdlib.h>
 #include "dbStaticLib.h"
 #include "epicsString.h"
 #include "epicsStdioRedirect.h"
 #include "iocsh.h"
 #include "epicsVersion.h"
 #include "dbAccess.h"
+#include "dbCommon.h"
+#include "gpHash.h"
+#include "initHooks.h"
 #include "epicsExport.h"
 
+#include "globMatch.h"
+#include "dbWalk.h"
+#include "listOutput.h"
+
 #ifndef vxWorks
 #define dbla __dbla
 #endif
 
-long epicsShareAPI dbla(const char* match)
-{
 #if EPICS_VERSION*10000+EPICS_REVISION*100+EPICS_MODIFICATION >= 31411
-    DBENTRY dbEntry;
-    long status;
+struct dblaContext {
+    globMatcher* matcher;
+    int format;
+};
+
+static const char* dblaColumns[] = { "alias", "record" };
+
+static void dblaPrint(const struct dblaContext* ctx, const char* alias, const char* realname)
+{
+    if (ctx->format != LIST_TEXT)
+    {
+        const char* values[2];
+        values[0] = alias;
+        values[1] = realname;
+        listOutputRow(ctx->format, 2, dblaColumns, values);
+    }
+    else
+        printf("%s -> %s\n", alias, realname);
+}
+
+/* dbWalkRecords callback, possibly in parallel worker threads */
+static void dblaWalkRecord(DBENTRY *pdbEntry, void *arg)
+{
+    const struct dblaContext* ctx = arg;
+    const char* alias;
+    const char* realname;
+
+    if (!dbIsAlias(pdbEntry)) return;
+
+    dbFindField(pdbEntry, "NAME");
+    realname = dbGetString(pdbEntry);
+    alias = dbGetRecordName(pdbEntry);
+
+    if (globMatch(ctx->matcher, realname) || globMatch(ctx->matcher, alias))
+        dblaPrint(ctx, alias, realname);
+}
+
+/*
+    Alias index, built at initHookAfterInitDatabase (no aliases can be
+    created later). All aliases in database order plus one hash table
+    for both directions: alias name -> alias, record name -> first alias
+    of this record. Aliases of aliases already point to the real record
+    (dbCreateAlias resolves them), so the real name is taken from the
+    record itself.
+*/
+
+struct dblaAlias {
     const char* alias;
     const char* realname;
+    struct dblaAlias* next;     /* next alias of same record */
+};
+
+static struct dblaAlias* dblaIndex;
+static size_t dblaIndexCount;
+static struct gphPvt* dblaIndexHash;
+static int dblaIndexReady;
+static char dblaAliasKey, dblaRecordKey;    /* gpHash ids for the two directions */
+
+static void dblaIndexBuild(void)
+{
+    DBENTRY dbEntry;
+    long status;
+    size_t n = 0;
 
+    if (dblaIndexReady || !pdbbase) return;
     dbInitEntry(pdbbase, &dbEntry);
     for (status = dbFirstRecordType(&dbEntry); !status; status = dbNextRecordType(&dbEntry))
     for (status = dbFirstRecord(&dbEntry); !status; status = dbNextRecord(&dbEntry))
+        if (dbIsAlias(&dbEntry)) n++;
+    dblaIndex = calloc(n + 1, sizeof(struct dblaAlias));
+    if (!dblaIndex)
+    {
+        dbFinishEntry(&dbEntry);
+        return;
+    }
+    gphInitPvt(&dblaIndexHash, n < 256 ? 256 : n < 65536 ? 4096 : 65536);
+    for (status = dbFirstRecordType(&dbEntry); !status; status = dbNextRecordType(&dbEntry))
+    for (status = dbFirstRecord(&dbEntry); !status && dblaIndexCount < n; status = dbNextRecord(&dbEntry))
     {
+        struct dblaAlias* a;
+        struct dblaAlias** pnext;
+        GPHENTRY* pgph;
+
         if (!dbIsAlias(&dbEntry)) continue;
+        a = &dblaIndex[dblaIndexCount++];
+        a->alias = dbGetRecordName(&dbEntry);
+        a->realname = ((dbCommon*)dbEntry.precnode->precord)->name;
+        pgph = gphAdd(dblaIndexHash, a->alias, &dblaAliasKey);
+        if (pgph) pgph->userPvt = a;
+        pgph = gphFind(dblaIndexHash, a->realname, &dblaRecordKey);
+        if (!pgph)
+        {
+            pgph = gphAdd(dblaIndexHash, a->realname, &dblaRecordKey);
+            if (pgph) pgph->userPvt = a;
+            continue;
+        }
+        /* append to keep database order */
+        for (pnext = (struct dblaAlias**)&pgph->userPvt; *pnext; pnext = &(*pnext)->next);
+        *pnext = a;
+    }
+    dbFinishEntry(&dbEntry);
+    dblaIndexReady = 1;
+}
 
-        dbFindField(&dbEntry, "NAME");
-        realname = dbGetString(&dbEntry);
-        alias = dbGetRecordName(&dbEntry);
+static void dblaInitHook(initHookState state)
+{
+    if (state != initHookAfterInitDatabase) return;
+    dblaIndexBuild();
+}
+
+/* answer from the index, return -1 if not possible */
+static long dblaIndexQuery(const char* match, const struct dblaContext* ctx)
+{
+    GPHENTRY* pgph;
+    struct dblaAlias* a;
+    size_t i;
 
-        if (!match || epicsStrGlobMatch(realname, match) || epicsStrGlobMatch(alias, match))
+    if (!dblaIndexReady) return -1;
+    if (match && !strpbrk(match, "*?"))
+    {
+        /* exact name: either an alias or a record with aliases */
+        pgph = gphFind(dblaIndexHash, match, &dblaAliasKey);
+        if (pgph)
         {
-            printf("%s -> %s\n", alias, realname);
+            a = pgph->userPvt;
+            dblaPrint(ctx, a->alias, a->realname);
+            return 0;
         }
+        pgph = gphFind(dblaIndexHash, match, &dblaRecordKey);
+        if (pgph)
+            for (a = pgph->userPvt; a; a = a->next)
+                dblaPrint(ctx, a->alias, a->realname);
+        return 0;
     }
-    dbFinishEntry(&dbEntry);
+    /* pattern: only aliases are candidates */
+    for (i = 0; i < dblaIndexCount; i++)
+    {
+        a = &dblaIndex[i];
+        if (globMatch(ctx->matcher, a->realname) || globMatch(ctx->matcher, a->alias))
+            dblaPrint(ctx, a->alias, a->realname);
+    }
+    return 0;
+}
+#endif
+
+static long dblaList(const char* match, int format)
+{
+#if EPICS_VERSION*10000+EPICS_REVISION*100+EPICS_MODIFICATION >= 31411
+    struct dblaContext ctx;
+
+    ctx.matcher = match ? globCompile(match) : NULL;
+    ctx.format = format;
+    listOutputHeader(format, 2, dblaColumns);
+    if (dblaIndexQuery(match, &ctx) != 0)
+        dbWalkRecords(dblaWalkRecord, &ctx);
+    globFree(ctx.matcher);
 #endif
     return 0;
 }
 
+long epicsShareAPI dbla(const char* match)
+{
+    return dblaList(match, LIST_TEXT);
+}
+
 static const iocshFuncDef dblaDef =
     { "dbla", 1, (const iocshArg *[]) {
-    &(iocshArg) { "record_name_pattern", iocshArgString },
+    &(iocshArg) { "[-json|-csv] [-o file] record_name_pattern", iocshArgArgv },
 }};
 
+/*
+    dbla: List record aliases
+
+    Shows all aliases where the alias or the record name matches
+    the glob pattern.
+    After iocInit an exact name is looked up in the alias index in both
+    directions (alias -> record, record -> all its aliases) and patterns
+    are only matched against aliases, not against all records.
+
+    Output format:
+        -json : one JSON object per alias (JSON Lines)
+        -csv  : comma separated values with header line
+        Columns: alias, record
+        -o file : write to file, or to a command if file starts with |
+*/
+
 void dblaFunc(const iocshArgBuf *args)
 {
-    dbla(args[0].sval);
+    int argc = args[0].aval.ac;
+    char **argv = args[0].aval.av;
+    struct listOutput out;
+    int n;
+
+    n = listOutputArgs(&out, argc - 1, argv + 1);
+    if (n < 0)
+    {
+        fprintf(stderr, "usage: dbla [-json|-csv] [-o file] record_name_pattern\n");
+        return;
+    }
+    if (listOutputOpen(&out) != 0) return;
+    dblaList(argc > n + 1 ? argv[n + 1] : NULL, out.format);
+    listOutputClose(&out);
 }
 
 static void dblaRegistrar(void)
 {
     iocshRegister(&dblaDef, dblaFunc);
+#if EPICS_VERSION*10000+EPICS_REVISION*100+EPICS_MODIFICATION >= 31411
+    initHookRegister(dblaInitHook);
+#endif
 }
 
 epicsExportRegistrar(dblaRegistrar);
@@ -26,48 +26,104 @@
 #include "dbAccess.h"
 #include "epicsString.h"
 #include "iocsh.h"
-#include "dbAccess.h"
 #include "epicsExport.h"
 
-long dbNextMatchingInfo(DBENTRY *pdbentry, const char* patternlist[])
+#include "globMatch.h"
+#include "dbWalk.h"
+#include "dbli.h"
+#include "listOutput.h"
+
+struct dbliContext {
+    globMatcher* matcher;
+    int format;
+};
+
+static const char* dbliColumns[] = { "record", "info", "value" };
+
+/* advance to the next info item of any record */
+static long dbNextInfoEntry(DBENTRY *pdbentry)
 {
     long status = 0;
-    const char** pattern;
 
     if (!pdbentry->precordType)
     {
         status = dbFirstRecordType(pdbentry);
         if (status) return status;
     }
-    while(1) {
-        status = dbNextInfo(pdbentry);
+    status = dbNextInfo(pdbentry);
+    while (status) {
+        status = dbNextRecord(pdbentry);
         while (status) {
-            status = dbNextRecord(pdbentry);
-            while (status) {
-                status = dbNextRecordType(pdbentry);
-                if (status) return status;
-                status = dbFirstRecord(pdbentry);
-            }
-            status = dbFirstInfo(pdbentry);
+            status = dbNextRecordType(pdbentry);
+            if (status) return status;
+            status = dbFirstRecord(pdbentry);
         }
+        status = dbFirstInfo(pdbentry);
+    }
+    return 0;
+}
+
+long dbNextMatchingInfo(DBENTRY *pdbentry, const char* patternlist[])
+{
+    long status = 0;
+    const char** pattern;
+
+    while(1) {
+        status = dbNextInfoEntry(pdbentry);
+        if (status) return status;
         if (!patternlist || !*patternlist) return 0;
         for (pattern = patternlist; *pattern; pattern++)
             if (epicsStrGlobMatch(dbGetInfoName(pdbentry), *pattern)) return 0;
     }
 }
 
-static void dblilist(const char** patternlist)
+static void dbliPrintInfo(DBENTRY *pdbentry, int format)
 {
-    DBENTRY dbentry;
     void* p;
 
-    dbInitEntry(pdbbase, &dbentry);
-    while (dbNextMatchingInfo(&dbentry, patternlist) == 0)
+    if (format != LIST_TEXT)
     {
-        printf("%s.%s \"%s\"", dbGetRecordName(&dbentry), dbGetInfoName(&dbentry), dbGetInfoString(&dbentry));
-        if ((p = dbGetInfoPointer(&dbentry)) != NULL) printf(" %p", p);
-        printf("\n");
+        const char* values[3];
+        values[0] = dbGetRecordName(pdbentry);
+        values[1] = dbGetInfoName(pdbentry);
+        values[2] = dbGetInfoString(pdbentry);
+        listOutputRow(format, 3, dbliColumns, values);
+        return;
     }
+    printf("%s.%s \"%s\"", dbGetRecordName(pdbentry), dbGetInfoName(pdbentry), dbGetInfoString(pdbentry));
+    if ((p = dbGetInfoPointer(pdbentry)) != NULL) printf(" %p", p);
+    printf("\n");
+}
+
+/* dbWalkRecords callback, possibly in parallel worker threads */
+static void dbliWalkRecord(DBENTRY *pdbentry, void *arg)
+{
+    const struct dbliContext* ctx = arg;
+    long status;
+
+    for (status = dbFirstInfo(pdbentry); !status; status = dbNextInfo(pdbentry))
+    {
+        if (!globMatch(ctx->matcher, dbGetInfoName(pdbentry))) continue;
+        dbliPrintInfo(pdbentry, ctx->format);
+    }
+}
+
+/* dbliFindMatching callback */
+static void dbliPrintItem(DBENTRY *pdbentry, void *arg)
+{
+    dbliPrintInfo(pdbentry, *(const int *)arg);
+}
+
+static void dblilist(const char** patternlist, int format)
+{
+    struct dbliContext ctx;
+
+    ctx.matcher = globCompileList(patternlist);
+    ctx.format = format;
+    listOutputHeader(format, 3, dbliColumns);
+    if (dbliFindMatching(patternlist, dbliPrintItem, &format) < 0)
+        dbWalkRecords(dbliWalkRecord, &ctx);
+    globFree(ctx.matcher);
 }
 
 /* for vxWorks shell: up to 10 args */
@@ -85,17 +141,42 @@ void dbli(const char* p0, const char* p1, const char* p2, const char* p3, const
     patternlist[8] = p8;
     patternlist[9] = p9;
     patternlist[10] = NULL;
-    dblilist(patternlist);
+    dblilist(patternlist, LIST_TEXT);
 }
 
 static const iocshFuncDef dbliDef =
     { "dbli", 1, (const iocshArg *[]) {
-    &(iocshArg) { "pattern...", iocshArgArgv },
+    &(iocshArg) { "[-json|-csv] [-o file] pattern...", iocshArgArgv },
 }};
 
+/*
+    dbli: List info items
+
+    Shows all info items where the name matches any of the glob patterns.
+
+    Output format:
+        -json : one JSON object per info item (JSON Lines)
+        -csv  : comma separated values with header line
+        Columns: record, info, value
+        -o file : write to file, or to a command if file starts with |
+*/
+
 void dbliFunc(const iocshArgBuf *args)
 {
-    dblilist((const char**)args[0].aval.av+1);
+    int argc = args[0].aval.ac;
+    char **argv = args[0].aval.av;
+    struct listOutput out;
+    int n;
+
+    n = listOutputArgs(&out, argc - 1, argv + 1);
+    if (n < 0)
+    {
+        fprintf(stderr, "usage: dbli [-json|-csv] [-o file] pattern...\n");
+        return;
+    }
+    if (listOutputOpen(&out) != 0) return;
+    dblilist((const char**)argv + 1 + n, out.format);
+    listOutputClose(&out);
 }
 
 static void dbliRegistrar(void)
@@ -0,0 +1,42 @@
+#ifndef dbli_h
+#define dbli_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "dbStaticLib.h"
+#include "epicsVersion.h"
+
+/* Called for each info item found, with the entry positioned at the
+   record and the info item, use dbGetRecordName, dbGetInfoString,
+   dbGetInfoPointer, etc. The entry must not be moved. */
+typedef void (*dbliInfoFunc)(DBENTRY *pdbEntry, void *arg);
+
+/* Call func for every record that has an info item with exactly this
+   name, in database order. After iocInit this uses an index and takes
+   time proportional to the number of results, before it scans the
+   database. Returns the number of items found. */
+long dbliFind(const char *infoname, dbliInfoFunc func, void *arg);
+
+/* Call func for every info item with a name matching any of the glob
+   patterns, in database order. Returns the number of items found or
+   -1 if the index is not available (before iocInit). */
+long dbliFindMatching(const char *patternlist[], dbliInfoFunc func, void *arg);
+
+/* The index is built at iocInit. Call this after adding or deleting
+   info items (not needed for dbPutInfo on existing items). */
+void dbliIndexRebuild(void);
+
+#if EPICS_VERSION*10000+EPICS_REVISION*100 < 70000
+/* Advance to the next info item (of any record) matching any of the
+   glob patterns. Start with an entry fresh from dbInitEntry.
+   Base 7 has its own version with a single pattern. */
+long dbNextMatchingInfo(DBENTRY *pdbentry, const char* patternlist[]);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
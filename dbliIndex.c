@@ -0,0 +1,290 @@
+/* dbliIndex.c
+*
+*  find info items by name
+*
+* Copyright (C) 2026 Dirk Zimoch
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+#include <stdlib.h>
+#include "dbStaticLib.h"
+#include "dbAccess.h"
+#include "gpHash.h"
+#include "epicsMutex.h"
+#include "initHooks.h"
+#include "epicsExport.h"
+
+#include "globMatch.h"
+#include "dbli.h"
+
+/*
+    Info index: info name -> all items with that name in database order.
+    Built at initHookAfterInitDatabase when device support has attached
+    its info pointers. The index refers to the info nodes, thus values
+    changed later with dbPutInfo are seen, but added or deleted info
+    items need dbliIndexRebuild().
+*/
+
+struct dbliItem {
+    dbRecordType *precordType;
+    dbRecordNode *precnode;
+    dbInfoNode *pinfonode;
+    unsigned long seq;          /* position in database order */
+};
+
+struct dbliName {
+    struct dbliItem *items;
+    size_t count, size;
+    char name[1];
+};
+
+static struct gphPvt *dbliIndexHash;
+static struct dbliName **dbliIndexNames;
+static size_t dbliIndexCount, dbliIndexSize;
+static epicsMutexId dbliIndexLock;
+static int dbliIndexReady;
+
+static void dbliIndexFree(void)
+{
+    size_t i;
+
+    for (i = 0; i < dbliIndexCount; i++)
+    {
+        free(dbliIndexNames[i]->items);
+        free(dbliIndexNames[i]);
+    }
+    free(dbliIndexNames);
+    dbliIndexNames = NULL;
+    dbliIndexCount = dbliIndexSize = 0;
+    if (dbliIndexHash) gphFreeMem(dbliIndexHash);
+    dbliIndexHash = NULL;
+    dbliIndexReady = 0;
+}
+
+static struct dbliName *dbliIndexName(const char *name)
+{
+    GPHENTRY *pgph;
+    struct dbliName *pname;
+
+    pgph = gphFind(dbliIndexHash, name, &dbliIndexHash);
+    if (pgph) return pgph->userPvt;
+
+    if (dbliIndexCount == dbliIndexSize)
+    {
+        struct dbliName **names;
+        size_t size = dbliIndexSize ? dbliIndexSize * 2 : 64;
+
+        names = realloc(dbliIndexNames, size * sizeof(struct dbliName *));
+        if (!names) return NULL;
+        dbliIndexNames = names;
+        dbliIndexSize = size;
+    }
+    pname = calloc(1, sizeof(struct dbliName) + strlen(name));
+    if (!pname) return NULL;
+    strcpy(pname->name, name);
+    pgph = gphAdd(dbliIndexHash, pname->name, &dbliIndexHash);
+    if (!pgph)
+    {
+        free(pname);
+        return NULL;
+    }
+    pgph->userPvt = pname;
+    dbliIndexNames[dbliIndexCount++] = pname;
+    return pname;
+}
+
+void dbliIndexRebuild(void)
+{
+    DBENTRY dbEntry;
+    long status;
+    unsigned long seq = 0;
+
+    if (!pdbbase) return;
+    if (!dbliIndexLock) dbliIndexLock = epicsMutexMustCreate();
+    epicsMutexMustLock(dbliIndexLock);
+    dbliIndexFree();
+    gphInitPvt(&dbliIndexHash, 256);
+    dbInitEntry(pdbbase, &dbEntry);
+    for (status = dbFirstRecordType(&dbEntry); !status; status = dbNextRecordType(&dbEntry))
+    for (status = dbFirstRecord(&dbEntry); !status; status = dbNextRecord(&dbEntry))
+    {
+        #ifdef DBRN_FLAGS_ISALIAS
+        if (dbIsAlias(&dbEntry)) continue;
+        #endif
+        for (status = dbFirstInfo(&dbEntry); !status; status = dbNextInfo(&dbEntry))
+        {
+            struct dbliName *pname = dbliIndexName(dbGetInfoName(&dbEntry));
+            struct dbliItem *item;
+
+            if (!pname) continue;
+            if (pname->count == pname->size)
+            {
+                size_t size = pname->size ? pname->size * 2 : 16;
+                item = realloc(pname->items, size * sizeof(struct dbliItem));
+                if (!item) continue;
+                pname->items = item;
+                pname->size = size;
+            }
+            item = &pname->items[pname->count++];
+            item->precordType = dbEntry.precordType;
+            item->precnode = dbEntry.precnode;
+            item->pinfonode = dbEntry.pinfonode;
+            item->seq = seq++;
+        }
+    }
+    dbFinishEntry(&dbEntry);
+    dbliIndexReady = 1;
+    epicsMutexUnlock(dbliIndexLock);
+}
+
+static void dbliInitHook(initHookState state)
+{
+    if (state != initHookAfterInitDatabase) return;
+    dbliIndexRebuild();
+}
+
+static void dbliPosition(DBENTRY *pdbentry, const struct dbliItem *item)
+{
+    pdbentry->precordType = item->precordType;
+    pdbentry->precnode = item->precnode;
+    pdbentry->pinfonode = item->pinfonode;
+    pdbentry->pflddes = NULL;
+    pdbentry->pfield = NULL;
+}
+
+/* copy the positions of all items of one name, with dbliIndexLock held */
+static int dbliIndexAppend(const struct dbliName *pname, struct dbliItem **items, size_t *n, size_t *size)
+{
+    if (*n + pname->count > *size)
+    {
+        size_t newsize = *size ? *size : 16;
+        struct dbliItem *p;
+
+        while (newsize < *n + pname->count) newsize *= 2;
+        p = realloc(*items, newsize * sizeof(struct dbliItem));
+        if (!p) return -1;
+        *items = p;
+        *size = newsize;
+    }
+    memcpy(*items + *n, pname->items, pname->count * sizeof(struct dbliItem));
+    *n += pname->count;
+    return 0;
+}
+
+static int dbliItemCompare(const void *a, const void *b)
+{
+    unsigned long sa = ((const struct dbliItem *)a)->seq;
+    unsigned long sb = ((const struct dbliItem *)b)->seq;
+    return sa < sb ? -1 : sa > sb;
+}
+
+/* call func for copied items, without holding dbliIndexLock */
+static long dbliIndexCall(struct dbliItem *items, size_t n, dbliInfoFunc func, void *arg)
+{
+    DBENTRY dbEntry;
+    size_t i;
+
+    dbInitEntry(pdbbase, &dbEntry);
+    for (i = 0; i < n; i++)
+    {
+        dbliPosition(&dbEntry, &items[i]);
+        func(&dbEntry, arg);
+    }
+    dbFinishEntry(&dbEntry);
+    free(items);
+    return (long)n;
+}
+
+long dbliFind(const char *infoname, dbliInfoFunc func, void *arg)
+{
+    DBENTRY dbEntry;
+    long status, n = 0;
+
+    if (!pdbbase || !infoname) return 0;
+    if (dbliIndexLock)
+    {
+        struct dbliItem *items = NULL;
+        size_t count = 0, size = 0;
+        GPHENTRY *pgph;
+
+        epicsMutexMustLock(dbliIndexLock);
+        if (dbliIndexReady)
+        {
+            pgph = gphFind(dbliIndexHash, infoname, &dbliIndexHash);
+            if (!pgph || dbliIndexAppend(pgph->userPvt, &items, &count, &size) == 0)
+            {
+                epicsMutexUnlock(dbliIndexLock);
+                return dbliIndexCall(items, count, func, arg);
+            }
+        }
+        epicsMutexUnlock(dbliIndexLock);
+        free(items);
+    }
+    dbInitEntry(pdbbase, &dbEntry);
+    for (status = dbFirstRecordType(&dbEntry); !status; status = dbNextRecordType(&dbEntry))
+    for (status = dbFirstRecord(&dbEntry); !status; status = dbNextRecord(&dbEntry))
+    {
+        #ifdef DBRN_FLAGS_ISALIAS
+        if (dbIsAlias(&dbEntry)) continue;
+        #endif
+        if (dbFindInfo(&dbEntry, infoname) != 0) continue;
+        func(&dbEntry, arg);
+        n++;
+    }
+    dbFinishEntry(&dbEntry);
+    return n;
+}
+
+long dbliFindMatching(const char *patternlist[], dbliInfoFunc func, void *arg)
+{
+    globMatcher *matcher;
+    struct dbliItem *items = NULL;
+    size_t i, n = 0, size = 0;
+
+    if (!pdbbase || !dbliIndexLock) return -1;
+    matcher = globCompileList(patternlist);
+    epicsMutexMustLock(dbliIndexLock);
+    if (!dbliIndexReady)
+    {
+        epicsMutexUnlock(dbliIndexLock);
+        globFree(matcher);
+        return -1;
+    }
+    for (i = 0; i < dbliIndexCount; i++)
+    {
+        if (!globMatch(matcher, dbliIndexNames[i]->name)) continue;
+        if (dbliIndexAppend(dbliIndexNames[i], &items, &n, &size) != 0)
+        {
+            epicsMutexUnlock(dbliIndexLock);
+            globFree(matcher);
+            free(items);
+            return -1;
+        }
+    }
+    epicsMutexUnlock(dbliIndexLock);
+    globFree(matcher);
+    /* items of different names are interleaved in database order */
+    qsort(items, n, sizeof(struct dbliItem), dbliItemCompare);
+    return dbliIndexCall(items, n, func, arg);
+}
+
+static void dbliIndexRegistrar(void)
+{
+    if (!dbliIndexLock) dbliIndexLock = epicsMutexMustCreate();
+    initHookRegister(dbliInitHook);
+}
+
+epicsExportRegistrar(dbliIndexRegistrar);
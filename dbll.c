@@ -25,31 +25,609 @@
 #include "epicsVersion.h"
 #ifdef BASE_VERSION
 #define EPICS_3_13
-extern int epicsStrGlobMatch(const char *str, const char *pattern);
 extern struct dbBase *pdbbase;
 #else
 #include "iocsh.h"
 #include "epicsStdioRedirect.h"
 #include "dbAddr.h"
 #include "dbAccessDefs.h"
+#include "dbCommon.h"
+#include "dbLock.h"
+#include "epicsMutex.h"
+#include "gpHash.h"
+#include "initHooks.h"
+#include "asTrapWrite.h"
+#if EPICS_VERSION*10000+EPICS_REVISION*100+EPICS_MODIFICATION > 31500
+#include "dbChannel.h"
+#endif
 #include "epicsExport.h"
 #endif
 
-long dbll(const char* match, const char* types)
+#include "dbll.h"
+#include "globMatch.h"
+#ifndef EPICS_3_13
+#include "dbWalk.h"
+#include "listOutput.h"
+
+static const char *dbllColumns[] = { "record", "field", "type", "link" };
+#endif
+
+struct dbllFilter {
+    const char *match;
+    const char *matchfield;
+    char *alt_match;
+    globMatcher *matcher;
+    globMatcher *alt_matcher;
+    unsigned int typemask;
+    int format;
+};
+
+/* classify the link at the current entry, return its symbol or NULL if filtered out */
+static const char* dbllLinkSymbol(DBENTRY *pdbEntry, unsigned int typemask)
+{
+    DBLINK *link = (DBLINK *)pdbEntry->pfield;
+
+    if (!link->value.pv_link.pvname) return NULL;
+    switch (link->type)
+    {
+        default:
+            return NULL;
+        #ifdef PN_LINK
+        case PN_LINK:
+        #endif
+        case PV_LINK:
+        case DB_LINK:
+            if (!(typemask & DBLL_DMASK)) return NULL;
+            break;
+        case CA_LINK:
+            if (!(typemask & DBLL_CMASK)) return NULL;
+            break;
+    }
+    switch (pdbEntry->pflddes->field_type)
+    {
+        default:
+            return NULL;
+        case DBF_INLINK:
+            if (!(typemask & DBLL_IMASK)) return NULL;
+            if (link->value.pv_link.pvlMask & pvlOptPP
+                #ifdef PN_LINK
+                || link->type == PN_LINK
+                #endif
+                )
+                return "<=p";
+            if (typemask & DBLL_PMASK) return NULL;
+            return "<==";
+        case DBF_OUTLINK:
+            if (!(typemask & DBLL_OMASK)) return NULL;
+            if (link->value.pv_link.pvlMask & pvlOptPP)
+                return "p=>";
+            if (typemask & DBLL_PMASK) return NULL;
+            return "==>";
+        case DBF_FWDLINK:
+            if (!(typemask & DBLL_FMASK)) return NULL;
+            return "p->";
+    }
+}
+
+/* print the link at the current entry if its target matches */
+static void dbllPrintLink(DBENTRY *pdbEntry, const char *symbol, void *arg)
+{
+    const struct dbllFilter *filter = arg;
+    const char* target = ((DBLINK *)pdbEntry->pfield)->value.pv_link.pvname;
+
+    if (!filter->match || (!strchr(target, '.') == !filter->matchfield ? globMatch(filter->matcher, target)
+        : filter->alt_match ? globMatch(filter->alt_matcher, target) : 0))
+    {
+#ifndef EPICS_3_13
+        if (filter->format != LIST_TEXT)
+        {
+            const char *values[4];
+            values[0] = dbGetRecordName(pdbEntry);
+            values[1] = dbGetFieldName(pdbEntry);
+            values[2] = symbol;
+            values[3] = dbGetString(pdbEntry);
+            listOutputRow(filter->format, 4, dbllColumns, values);
+            return;
+        }
+#endif
+        printf("%s.%s %s %s\n", dbGetRecordName(pdbEntry), dbGetFieldName(pdbEntry),
+            symbol, dbGetString(pdbEntry));
+    }
+}
+
+/* walk all links of the record at the current entry */
+static void dbllRecordLinks(DBENTRY *pdbEntry, unsigned int typemask, dbllLinkFunc func, void *arg)
+{
+    int ilink;
+
+    #ifdef DBRN_FLAGS_ISALIAS
+    if (dbIsAlias(pdbEntry)) return;
+    #endif
+
+    if (typemask & DBLL_RMASK) func(pdbEntry, NULL, arg);
+    for (ilink = 0; dbGetLinkField(pdbEntry, ilink) == 0; ilink++)
+    {
+        const char *symbol = dbllLinkSymbol(pdbEntry, typemask);
+        if (symbol) func(pdbEntry, symbol, arg);
+    }
+}
+
+/* walk all links of all records in database order */
+long dbllForEachLink(unsigned int typemask, dbllLinkFunc func, void *arg)
+{
+    DBENTRY dbEntry;
+    long status;
+
+    dbInitEntry(pdbbase, &dbEntry);
+    for (status = dbFirstRecordType(&dbEntry); !status; status = dbNextRecordType(&dbEntry))
+    for (status = dbFirstRecord(&dbEntry); !status; status = dbNextRecord(&dbEntry))
+        dbllRecordLinks(&dbEntry, typemask, func, arg);
+    dbFinishEntry(&dbEntry);
+    return 0;
+}
+
+#ifndef EPICS_3_13
+/* dbWalkRecords callback, possibly in parallel worker threads */
+static void dbllWalkRecord(DBENTRY *pdbEntry, void *arg)
+{
+    const struct dbllFilter *filter = arg;
+    dbllRecordLinks(pdbEntry, filter->typemask, dbllPrintLink, arg);
+}
+#endif
+
+#ifndef EPICS_3_13
+/*
+    Reverse link index: target record name -> links pointing to it.
+
+    Built once at initHookAfterInitDatabase. Links modified at runtime
+    are re-indexed by an asTrapWrite listener (i.e. for puts over CA/PVA
+    to link fields covered by a TRAPWRITE access security rule) or by
+    calling dbllIndexUpdate(recordname) after modifying links otherwise
+    (code, dbpf). Each hit is validated against the current link value
+    under the record lock when queried, so entries of links that have
+    been redirected are dropped lazily.
+*/
+
+struct dbllRef {
+    struct dbllRef *next;
+    const char *source;     /* name of record owning the link */
+    int ilink;              /* link field index within record type */
+};
+
+struct dbllTarget {
+    struct dbllRef *refs;
+    char name[1];           /* allocated to fit */
+};
+
+static struct gphPvt *dbllIndexHash;
+static struct dbllTarget **dbllIndexSorted;  /* sorted by name for prefix queries */
+static size_t dbllIndexCount, dbllIndexSize;
+static epicsMutexId dbllIndexLock;
+static int dbllIndexReady;
+
+static int dbllIndexIsPvLink(const DBLINK *link)
+{
+    switch (link->type)
+    {
+        #ifdef PN_LINK
+        case PN_LINK:
+        #endif
+        case PV_LINK:
+        case DB_LINK:
+        case CA_LINK:
+            return link->value.pv_link.pvname != NULL;
+        default:
+            return 0;
+    }
+}
+
+static int dbllIndexCompare(const void *a, const void *b)
+{
+    return strcmp((*(struct dbllTarget **)a)->name, (*(struct dbllTarget **)b)->name);
+}
+
+/* first sorted position with name >= key (considering only keylen chars) */
+static size_t dbllIndexLowerBound(const char *key, size_t keylen)
+{
+    size_t lo = 0, hi = dbllIndexCount, mid;
+
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        if (strncmp(dbllIndexSorted[mid]->name, key, keylen) < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+/* find or create the target for the record part of a link pvname */
+static struct dbllTarget *dbllIndexGetTarget(const char *pvname, size_t len, int keepSorted)
+{
+    struct dbllTarget *target;
+    GPHENTRY *pgph;
+    char key[256];
+
+    if (len >= sizeof(key)) return NULL;
+    memcpy(key, pvname, len);
+    key[len] = 0;
+    pgph = gphFind(dbllIndexHash, key, &dbllIndexHash);
+    if (pgph) return pgph->userPvt;
+
+    if (dbllIndexCount == dbllIndexSize)
+    {
+        struct dbllTarget **sorted;
+        size_t size = dbllIndexSize ? dbllIndexSize * 2 : 1024;
+
+        sorted = realloc(dbllIndexSorted, size * sizeof(struct dbllTarget *));
+        if (!sorted) return NULL;
+        dbllIndexSorted = sorted;
+        dbllIndexSize = size;
+    }
+    target = malloc(sizeof(struct dbllTarget) + len);
+    if (!target) return NULL;
+    memcpy(target->name, key, len + 1);
+    pgph = gphAdd(dbllIndexHash, target->name, &dbllIndexHash);
+    if (!pgph)
+    {
+        free(target);
+        return NULL;
+    }
+    pgph->userPvt = target;
+    target->refs = NULL;
+    if (keepSorted)
+    {
+        size_t pos = dbllIndexLowerBound(target->name, len + 1);
+        memmove(dbllIndexSorted + pos + 1, dbllIndexSorted + pos,
+            (dbllIndexCount - pos) * sizeof(struct dbllTarget *));
+        dbllIndexSorted[pos] = target;
+    }
+    else
+    {
+        dbllIndexSorted[dbllIndexCount] = target;
+    }
+    dbllIndexCount++;
+    return target;
+}
+
+static void dbllIndexAdd(const char *source, int ilink, const char *pvname, int keepSorted)
+{
+    struct dbllTarget *target;
+    struct dbllRef *ref;
+
+    target = dbllIndexGetTarget(pvname, strcspn(pvname, ". "), keepSorted);
+    if (!target) return;
+    for (ref = target->refs; ref; ref = ref->next)
+        if (ref->ilink == ilink && ref->source == source) return;
+    ref = malloc(sizeof(struct dbllRef));
+    if (!ref) return;
+    ref->source = source;
+    ref->ilink = ilink;
+    ref->next = target->refs;
+    target->refs = ref;
+}
+
+/* add all links of the record at the current entry */
+static void dbllIndexAddRecord(DBENTRY *pdbEntry, int keepSorted)
+{
+    int ilink;
+
+    for (ilink = 0; dbGetLinkField(pdbEntry, ilink) == 0; ilink++)
+    {
+        DBLINK *link = (DBLINK *)pdbEntry->pfield;
+        if (!dbllIndexIsPvLink(link)) continue;
+        dbllIndexAdd(dbGetRecordName(pdbEntry), ilink, link->value.pv_link.pvname, keepSorted);
+    }
+}
+
+static void dbllIndexBuild(void)
 {
     DBENTRY dbEntry;
-    long status = 0;
-    char *matchfield = NULL;
-    char *alt_match = NULL;
-    const char* symbol;
-    const int imask = 1;
-    const int omask = 2;
-    const int fmask = 4;
-    const int pmask = 8;
-    const int cmask = 16;
-    const int dmask = 32;
+    long status;
+
+    if (dbllIndexReady) return;
+    dbllIndexLock = epicsMutexMustCreate();
+    gphInitPvt(&dbllIndexHash, 65536);
+    epicsMutexMustLock(dbllIndexLock);
+    dbInitEntry(pdbbase, &dbEntry);
+    for (status = dbFirstRecordType(&dbEntry); !status; status = dbNextRecordType(&dbEntry))
+    for (status = dbFirstRecord(&dbEntry); !status; status = dbNextRecord(&dbEntry))
+    {
+        #ifdef DBRN_FLAGS_ISALIAS
+        if (dbIsAlias(&dbEntry)) continue;
+        #endif
+        dbllIndexAddRecord(&dbEntry, 0);
+    }
+    dbFinishEntry(&dbEntry);
+    qsort(dbllIndexSorted, dbllIndexCount, sizeof(struct dbllTarget *), dbllIndexCompare);
+    dbllIndexReady = 1;
+    epicsMutexUnlock(dbllIndexLock);
+}
+
+long dbllIndexUpdate(const char *recordname)
+{
+    DBENTRY dbEntry;
+    long status;
+
+    if (!dbllIndexReady) return -1;
+    dbInitEntry(pdbbase, &dbEntry);
+    status = dbFindRecord(&dbEntry, recordname);
+    if (!status)
+    {
+        epicsMutexMustLock(dbllIndexLock);
+        dbllIndexAddRecord(&dbEntry, 1);
+        epicsMutexUnlock(dbllIndexLock);
+    }
+    dbFinishEntry(&dbEntry);
+    return status;
+}
+
+static void dbllTrapWriteListener(asTrapWriteMessage *pmessage, int after)
+{
+    const dbFldDes *pfldDes;
+    const char *recordname;
+
+    if (!after) return;
+#if EPICS_VERSION*10000+EPICS_REVISION*100+EPICS_MODIFICATION > 31500
+    {
+        dbChannel *chan = (dbChannel *)pmessage->serverSpecific;
+        pfldDes = dbChannelFldDes(chan);
+        recordname = dbChannelRecord(chan)->name;
+    }
+#else
+    {
+        DBADDR *paddr = (DBADDR *)pmessage->serverSpecific;
+        pfldDes = paddr->pfldDes;
+        recordname = paddr->precord->name;
+    }
+#endif
+    switch (pfldDes->field_type)
+    {
+        case DBF_INLINK:
+        case DBF_OUTLINK:
+        case DBF_FWDLINK:
+            dbllIndexUpdate(recordname);
+        default:
+            break;
+    }
+}
+
+static void dbllInitHook(initHookState state)
+{
+    if (state != initHookAfterInitDatabase) return;
+    dbllIndexBuild();
+    asTrapWriteRegisterListener(dbllTrapWriteListener);
+}
+
+/* run all links of one target through the filter, dropping stale entries */
+static void dbllIndexCheckTarget(DBENTRY *pdbEntry, struct dbllTarget *target,
+    const struct dbllFilter *filter)
+{
+    struct dbllRef **pref = &target->refs;
+    struct dbllRef *ref;
+    size_t len = strlen(target->name);
+
+    while ((ref = *pref) != NULL)
+    {
+        DBLINK *link;
+        const char *pvname;
+        dbCommon *precord;
+        int valid = 0;
+
+        if (dbFindRecord(pdbEntry, ref->source) == 0
+            && dbGetLinkField(pdbEntry, ref->ilink) == 0)
+        {
+            /* dbPutField may replace the link while we look at it */
+            precord = pdbEntry->precnode->precord;
+            dbScanLock(precord);
+            link = (DBLINK *)pdbEntry->pfield;
+            if (dbllIndexIsPvLink(link)
+                && (pvname = link->value.pv_link.pvname, strncmp(pvname, target->name, len) == 0)
+                && (pvname[len] == 0 || pvname[len] == '.' || pvname[len] == ' '))
+            {
+                const char *symbol = dbllLinkSymbol(pdbEntry, filter->typemask);
+                if (symbol) dbllPrintLink(pdbEntry, symbol, (void *)filter);
+                valid = 1;
+            }
+            dbScanUnlock(precord);
+        }
+        if (valid)
+        {
+            pref = &ref->next;
+        }
+        else
+        {
+            *pref = ref->next;
+            free(ref);
+        }
+    }
+}
+
+/* answer exact record name and "prefix*" queries from the index, return -1 if not possible */
+static long dbllIndexQuery(const struct dbllFilter *filter)
+{
+    DBENTRY dbEntry;
+    const char *match = filter->match;
+    size_t len, wild;
+    GPHENTRY *pgph;
+
+    if (!dbllIndexReady || !match) return -1;
+    len = strcspn(match, ".");
+    wild = strcspn(match, "*?[");
+    if (wild < len && (wild != len - 1 || match[wild] != '*')) return -1;
+
+    dbInitEntry(pdbbase, &dbEntry);
+    epicsMutexMustLock(dbllIndexLock);
+    if (wild >= len)
+    {
+        char key[256];
+        if (len < sizeof(key))
+        {
+            memcpy(key, match, len);
+            key[len] = 0;
+            pgph = gphFind(dbllIndexHash, key, &dbllIndexHash);
+            if (pgph) dbllIndexCheckTarget(&dbEntry, pgph->userPvt, filter);
+        }
+    }
+    else
+    {
+        size_t i;
+        for (i = dbllIndexLowerBound(match, wild);
+            i < dbllIndexCount && strncmp(dbllIndexSorted[i]->name, match, wild) == 0; i++)
+        {
+            dbllIndexCheckTarget(&dbEntry, dbllIndexSorted[i], filter);
+        }
+    }
+    epicsMutexUnlock(dbllIndexLock);
+    dbFinishEntry(&dbEntry);
+    return 0;
+}
+
+/*
+    Processing chain: breadth-first walk along FLNK, PP input and PP
+    output database links of one record and of every record processed
+    by them. Each record is expanded only once, thus loops terminate.
+*/
+
+struct dbllChainNode {
+    const char *name;       /* real record name */
+    int hop;
+};
+
+static void dbllChainRecord(const char *start, int depth)
+{
+    DBENTRY dbEntry;
+    DBENTRY dbTarget;
+    struct gphPvt *visited;
+    struct dbllChainNode *queue;
+    size_t head = 0, tail = 0, size = 256;
+    int maxhop = 0;
+
+    queue = malloc(size * sizeof(struct dbllChainNode));
+    if (!queue) return;
+    gphInitPvt(&visited, 256);
+    dbInitEntry(pdbbase, &dbEntry);
+    dbInitEntry(pdbbase, &dbTarget);
+
+    queue[tail].name = start;
+    queue[tail++].hop = 0;
+    gphAdd(visited, start, visited);
+    printf("%s\n", start);
+
+    while (head < tail)
+    {
+        struct dbllChainNode node = queue[head++];
+        int ilink;
+
+        if (depth > 0 && node.hop >= depth) continue;
+        if (dbFindRecord(&dbEntry, node.name) != 0) continue;
+        for (ilink = 0; dbGetLinkField(&dbEntry, ilink) == 0; ilink++)
+        {
+            DBLINK *link = (DBLINK *)dbEntry.pfield;
+            const char *symbol;
+            const char *pvname;
+            const char *field;
+            dbCommon *precord;
+            char key[PVNAME_STRINGSZ];
+            size_t len;
+
+            symbol = dbllLinkSymbol(&dbEntry, DBLL_IMASK|DBLL_OMASK|DBLL_FMASK|DBLL_DMASK|DBLL_PMASK);
+            if (!symbol) continue;
+            pvname = link->value.pv_link.pvname;
+            printf("%*s%d %s.%s %s %s", 2 * node.hop + 1, "", node.hop + 1,
+                node.name, dbGetFieldName(&dbEntry), symbol, dbGetString(&dbEntry));
+
+            len = strcspn(pvname, ". ");
+            field = pvname[len] == '.' ? pvname + len + 1 : "";
+            if (len >= sizeof(key)) len = sizeof(key) - 1;
+            memcpy(key, pvname, len);
+            key[len] = 0;
+            if (dbFindRecord(&dbTarget, key) != 0)
+            {
+                printf(" (not found)\n");
+                continue;
+            }
+            precord = (dbCommon *)dbTarget.precnode->precord;
+            if (gphFind(visited, precord->name, visited))
+            {
+                printf(" (visited)\n");
+                continue;
+            }
+            /* PP and FLNK only process passive records, except output links writing PROC */
+            if (precord->scan != 0 && !(dbEntry.pflddes->field_type == DBF_OUTLINK
+                && strncmp(field, "PROC", 4) == 0))
+            {
+                printf(" (not passive)\n");
+                continue;
+            }
+            printf("\n");
+            gphAdd(visited, precord->name, visited);
+            if (node.hop + 1 > maxhop) maxhop = node.hop + 1;
+            if (tail == size)
+            {
+                struct dbllChainNode *q = realloc(queue, 2 * size * sizeof(struct dbllChainNode));
+                if (!q) break;
+                queue = q;
+                size *= 2;
+            }
+            queue[tail].name = precord->name;
+            queue[tail++].hop = node.hop + 1;
+        }
+    }
+    printf("%s: %lu records processed in %d hops\n", start, (unsigned long)tail, maxhop);
+    dbFinishEntry(&dbTarget);
+    dbFinishEntry(&dbEntry);
+    gphFreeMem(visited);
+    free(queue);
+}
+
+static long dbllChain(const char* match, int depth)
+{
+    DBENTRY dbEntry;
+    long status;
+
+    if (!match || !*match)
+    {
+        fprintf(stderr, "usage: dbll -depth N record name pattern\n");
+        return -1;
+    }
+    dbInitEntry(pdbbase, &dbEntry);
+    if (!strpbrk(match, "*?["))
+    {
+        status = dbFindRecord(&dbEntry, match);
+        if (status)
+            fprintf(stderr, "dbll: record %s not found\n", match);
+        else
+            dbllChainRecord(((dbCommon *)dbEntry.precnode->precord)->name, depth);
+    }
+    else
+    {
+        globMatcher *matcher = globCompile(match);
+        for (status = dbFirstRecordType(&dbEntry); !status; status = dbNextRecordType(&dbEntry))
+        for (status = dbFirstRecord(&dbEntry); !status; status = dbNextRecord(&dbEntry))
+        {
+            #ifdef DBRN_FLAGS_ISALIAS
+            if (dbIsAlias(&dbEntry)) continue;
+            #endif
+            if (globMatch(matcher, dbGetRecordName(&dbEntry)))
+                dbllChainRecord(dbGetRecordName(&dbEntry), depth);
+        }
+        globFree(matcher);
+    }
+    dbFinishEntry(&dbEntry);
+    return 0;
+}
+#endif
+
+static long dbllList(const char* match, const char* types, int format)
+{
+    struct dbllFilter filter;
     unsigned int typemask;
 
+    filter.format = format;
+    filter.match = NULL;
+    filter.matchfield = NULL;
+    filter.alt_match = NULL;
+
     if (match)
     {
         if (!*match || strcmp(match, "*") == 0)
@@ -58,19 +636,22 @@ long dbll(const char* match, const char* types)
         }
         else
         {
-            matchfield = strchr(match, '.');
-            if (!matchfield)
+            filter.matchfield = strchr(match, '.');
+            if (!filter.matchfield)
             {
-                alt_match = malloc(strlen(match)+3);
-                sprintf(alt_match, "%s.*", match);
+                filter.alt_match = malloc(strlen(match)+3);
+                sprintf(filter.alt_match, "%s.*", match);
             }
-            else if (strcmp(matchfield, ".VAL") == 0 || strcmp(matchfield, ".*") == 0)
+            else if (strcmp(filter.matchfield, ".VAL") == 0 || strcmp(filter.matchfield, ".*") == 0)
             {
-                alt_match = malloc(matchfield-match+1);
-                sprintf(alt_match, "%.*s", (int)(matchfield-match), match);
+                filter.alt_match = malloc(filter.matchfield-match+1);
+                sprintf(filter.alt_match, "%.*s", (int)(filter.matchfield-match), match);
             }
         }
     }
+    filter.match = match;
+    filter.matcher = globCompile(match);
+    filter.alt_matcher = filter.alt_match ? globCompile(filter.alt_match) : NULL;
 
     if (types && *types)
     {
@@ -81,119 +662,61 @@ long dbll(const char* match, const char* types)
             {
                 case 'o':
                 case 'O':
-                    typemask |= omask;
+                    typemask |= DBLL_OMASK;
                     break;
                 case 'i':
                 case 'I':
-                    typemask |= imask;
+                    typemask |= DBLL_IMASK;
                     break;
                 case 'f':
                 case 'F':
-                    typemask |= fmask;
+                    typemask |= DBLL_FMASK;
                     break;
                 case 'p':
                 case 'P':
-                    typemask |= pmask;
+                    typemask |= DBLL_PMASK;
                     break;
                 case 'c':
                 case 'C':
-                    typemask |= cmask;
+                    typemask |= DBLL_CMASK;
                     break;
                 case 'd':
                 case 'D':
-                    typemask |= dmask;
+                    typemask |= DBLL_DMASK;
                     break;
            }
         }
-        if (!(typemask & (omask|imask|fmask))) typemask |= (omask|imask|fmask);
-        if (!(typemask & (cmask|dmask))) typemask |= (cmask|dmask);
+        if (!(typemask & (DBLL_OMASK|DBLL_IMASK|DBLL_FMASK))) typemask |= (DBLL_OMASK|DBLL_IMASK|DBLL_FMASK);
+        if (!(typemask & (DBLL_CMASK|DBLL_DMASK))) typemask |= (DBLL_CMASK|DBLL_DMASK);
     }
     else
     {
-        typemask = ~pmask;
+        typemask = ~(DBLL_PMASK|DBLL_RMASK);
     }
+    filter.typemask = typemask;
 
-    dbInitEntry(pdbbase, &dbEntry);
-    for (status = dbFirstRecordType(&dbEntry); !status; status = dbNextRecordType(&dbEntry))
-    for (status = dbFirstRecord(&dbEntry); !status; status = dbNextRecord(&dbEntry))
-    {
-        int ilink;
-
-        #ifdef DBRN_FLAGS_ISALIAS
-        if (dbIsAlias(&dbEntry)) continue;
-        #endif
-
-        for (ilink = 0; dbGetLinkField(&dbEntry, ilink) == 0; ilink++)
-        {
-            DBLINK *link = (DBLINK *)dbEntry.pfield;
-            const char* target = link->value.pv_link.pvname;
-            if (!target) continue;
-            switch (link->type)
-            {
-                default:
-                    continue;
-                #ifdef PN_LINK
-                case PN_LINK:
-                #endif
-                case PV_LINK:
-                case DB_LINK:
-                    if (!(typemask & dmask)) continue;
-                    break;
-                case CA_LINK:
-                    if (!(typemask & cmask)) continue;
-                    break;
-            }
-            switch (dbEntry.pflddes->field_type)
-            {
-                default:
-                    continue;
-                case DBF_INLINK:
-                    if (!(typemask & imask)) continue;
-                    if (link->value.pv_link.pvlMask & pvlOptPP
-                        #ifdef PN_LINK
-                        || link->type == PN_LINK
-                        #endif
-                        )
-                        symbol = "<=p";
-                    else
-                    {
-                        if (typemask & pmask) continue;
-                        symbol = "<==";
-                    }
-                    break;
-                case DBF_OUTLINK:
-                    if (!(typemask & omask)) continue;
-                    if (link->value.pv_link.pvlMask & pvlOptPP)
-                    symbol = "p=>";
-                    else
-                    {
-                        if (typemask & pmask) continue;
-                        symbol = "==>";
-                    }
-                    break;
-                case DBF_FWDLINK:
-                    if (!(typemask & fmask)) continue;
-                    symbol = "p->";
-                    break;
-            }
-            if (!match || (!strchr(target, '.') == !matchfield ? epicsStrGlobMatch(target, match)
-                : alt_match ? epicsStrGlobMatch(target, alt_match) : 0))
-            {
-                printf("%s.%s %s %s\n", dbGetRecordName(&dbEntry), dbGetFieldName(&dbEntry),
-                    symbol, dbGetString(&dbEntry));
-            }
-        }
-    }
-    dbFinishEntry(&dbEntry);
-    free(alt_match);
+#ifndef EPICS_3_13
+    listOutputHeader(format, 4, dbllColumns);
+    if (dbllIndexQuery(&filter) != 0)
+        dbWalkRecords(dbllWalkRecord, &filter);
+#else
+    dbllForEachLink(typemask, dbllPrintLink, &filter);
+#endif
+    globFree(filter.matcher);
+    globFree(filter.alt_matcher);
+    free(filter.alt_match);
     return 0;
 }
 
+long dbll(const char* match, const char* types)
+{
+    return dbllList(match, types, 0);
+}
+
 #ifndef EPICS_3_13
 static const iocshFuncDef dbllDef =
-    { "dbll", 2, (const iocshArg *[]) {
-    &(iocshArg) { "record name pattern", iocshArgString },
-    &(iocshArg) { "link type filter [iofcdp]", iocshArgString },
+    { "dbll", 1, (const iocshArg *[]) {
+    &(iocshArg) { "[-json|-csv] [-o file] [-depth N] record name pattern [link type filter [iofcdp]]", iocshArgArgv },
 }};
 
 /*
@@ -206,32 +729,80 @@ static const iocshFuncDef dbllDef =
             *.VAL : show links to VAL fiels of all records
             *.*ST : show links to fields that end with ST
 
+        After iocInit, patterns with an exact record name or a record
+        name prefix followed by * (e.g. recordname.*, XYZ:*.VAL) are
+        answered from the reverse link index without a database scan.
+        Other patterns scan the database, with dbWalkThreads worker
+        threads if that variable is set to more than 1.
+
     Link type filters:
         i : show only input links
         o : show only output links
         f : show only forward links
         c : show only channel access links
         d : show only database links
-        p : show only links that make the target process      
+        p : show only links that make the target process
 
     Example: Show all input or output PP links:
         dbll * iop
 
+    Processing chain mode:
+        dbll -depth N recordname
+        Follow FLNK, PP input and PP output database links from the
+        record breadth-first and show every link that makes another
+        record process, prefixed with its hop count. Records already
+        visited, non-passive and non-local targets are not followed.
+        N = 0 follows the chain without limit.
+
     Link symbols:
         Processing links: p
         Output links:  ==>
         Input links:   <==
         Forward links: P->
+
+    Output format:
+        -json : one JSON object per link (JSON Lines)
+        -csv  : comma separated values with header line
+        Columns: record, field, type (link symbol), link
+        -o file : write to file, or to a command if file starts with |
 */
 
 void dbllFunc(const iocshArgBuf *args)
 {
-    dbll(args[0].sval, args[1].sval);
+    int argc = args[0].aval.ac;
+    char **argv = args[0].aval.av;
+    struct listOutput out;
+    int n;
+
+    if (argc > 1 && strcmp(argv[1], "-depth") == 0)
+    {
+        char *end = NULL;
+        int depth = argc > 2 ? strtol(argv[2], &end, 10) : 0;
+        if (!end || *end || depth < 0 || argc < 4)
+        {
+            fprintf(stderr, "usage: dbll -depth N record name pattern\n");
+            return;
+        }
+        dbllChain(argv[3], depth);
+        return;
+    }
+    n = listOutputArgs(&out, argc - 1, argv + 1);
+    if (n < 0)
+    {
+        fprintf(stderr, "usage: dbll [-json|-csv] [-o file] record name pattern [iofcdp]\n");
+        return;
+    }
+    argc -= n;
+    argv += n;
+    if (listOutputOpen(&out) != 0) return;
+    dbllList(argc > 1 ? argv[1] : NULL, argc > 2 ? argv[2] : NULL, out.format);
+    listOutputClose(&out);
 }
 
 static void dbllRegistrar(void)
 {
     iocshRegister(&dbllDef, dbllFunc);
+    initHookRegister(dbllInitHook);
 }
 
 epicsExportRegistrar(dbllRegistrar);
@@ -0,0 +1,37 @@
+#ifndef dbll_h
+#define dbll_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "dbStaticLib.h"
+
+/* link type filter bits, see dbll */
+#define DBLL_IMASK 1    /* input links */
+#define DBLL_OMASK 2    /* output links */
+#define DBLL_FMASK 4    /* forward links */
+#define DBLL_PMASK 8    /* only links that make the target process */
+#define DBLL_CMASK 16   /* channel access links */
+#define DBLL_DMASK 32   /* database links */
+#define DBLL_RMASK 64   /* also call func once per record before its links, with symbol NULL */
+
+/* called for each link passing the filter with the entry positioned at the link field
+   symbol is the dbll link symbol: "<==" "<=p" "==>" "p=>" "p->" */
+typedef void (*dbllLinkFunc)(DBENTRY *pdbEntry, const char *symbol, void *arg);
+
+long dbllForEachLink(unsigned int typemask, dbllLinkFunc func, void *arg);
+
+/* After iocInit dbll answers record name queries from a reverse link index.
+   Links changed over CA to fields with a TRAPWRITE rule are re-indexed
+   automatically. Call this after changing links of a record otherwise
+   (from code or with dbpf) so that the new targets are found.
+   Returns 0 on success, non-zero if the record does not exist or the
+   index is not built yet. */
+long dbllIndexUpdate(const char *recordname);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,401 @@
+/* dbllExport.c
+*
+*  export the record link graph to a file
+*
+* Copyright (C) 2026 Dirk Zimoch
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include "dbStaticLib.h"
+#include "dbAccess.h"
+#include "dbCommon.h"
+#include "gpHash.h"
+#include "epicsString.h"
+#include "iocsh.h"
+#include "epicsStdioRedirect.h"
+#include "epicsExport.h"
+
+#include "dbll.h"
+
+#ifndef pvlOptMsMode
+#define pvlOptMsMode pvlOptMS
+#endif
+
+#define EXPORT_BUFFER_SIZE (1<<20)
+
+enum { EXPORT_DOT, EXPORT_GRAPHML, EXPORT_BINARY };
+
+/*
+    Binary format (all numbers little endian):
+    "DBLLGRF1"
+    'T' u8 len, name                record type, applies to following records
+    'N' u8 len, name                record (node)
+    'E' u8 flags, u8 len, field,    link of the last record (edge)
+        u16 len, target             target "record.field", record name of aliases resolved
+    'X'                             end of file
+    flags: bits 0-1: 0 = input link, 1 = output link, 2 = forward link
+           bit 2: PP, bit 3: CA link, bits 4-5: NMS/MS/MSI/MSS,
+           bit 6: target record not in this IOC
+*/
+
+#define EXPORT_FLAG_IN       0x00
+#define EXPORT_FLAG_OUT      0x01
+#define EXPORT_FLAG_FWD      0x02
+#define EXPORT_FLAG_PP       0x04
+#define EXPORT_FLAG_CA       0x08
+#define EXPORT_FLAG_MS_SHIFT 4
+#define EXPORT_FLAG_EXTERN   0x40
+
+struct exportName {
+    struct exportName *next;
+    char name[1];               /* allocated to fit */
+};
+
+struct exportCtx {
+    FILE *file;
+    int format;
+    DBENTRY target;
+    struct gphPvt *external;    /* non-local targets already declared */
+    struct exportName *names;   /* keys of the external hash */
+    const char *lastType;
+    unsigned long nodes, edges;
+};
+
+static void exportDotString(FILE *file, const char *s)
+{
+    putc('"', file);
+    for (; *s; s++)
+    {
+        if (*s == '"' || *s == '\\') putc('\\', file);
+        putc(*s, file);
+    }
+    putc('"', file);
+}
+
+static void exportXmlString(FILE *file, const char *s)
+{
+    for (; *s; s++)
+    {
+        switch (*s)
+        {
+            case '&': fputs("&amp;", file); break;
+            case '<': fputs("&lt;", file); break;
+            case '>': fputs("&gt;", file); break;
+            case '"': fputs("&quot;", file); break;
+            case '\'': fputs("&apos;", file); break;
+            default: putc(*s, file);
+        }
+    }
+}
+
+static void exportBinString(FILE *file, const char *s, int wide)
+{
+    size_t len = strlen(s);
+
+    if (len > (wide ? 0xffff : 0xff)) len = wide ? 0xffff : 0xff;
+    putc(len & 0xff, file);
+    if (wide) putc((len >> 8) & 0xff, file);
+    fwrite(s, 1, len, file);
+}
+
+static void exportHeader(struct exportCtx *ctx)
+{
+    FILE *file = ctx->file;
+
+    switch (ctx->format)
+    {
+        case EXPORT_DOT:
+            fputs("digraph \"dbll\" {\n", file);
+            break;
+        case EXPORT_GRAPHML:
+            fputs("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                "<graphml xmlns=\"http://graphml.graphdrawing.org/xmlns\">\n"
+                "<key id=\"rtype\" for=\"node\" attr.name=\"rtype\" attr.type=\"string\"/>\n"
+                "<key id=\"external\" for=\"node\" attr.name=\"external\" attr.type=\"boolean\"/>\n"
+                "<key id=\"field\" for=\"edge\" attr.name=\"field\" attr.type=\"string\"/>\n"
+                "<key id=\"tfield\" for=\"edge\" attr.name=\"tfield\" attr.type=\"string\"/>\n"
+                "<key id=\"ltype\" for=\"edge\" attr.name=\"ltype\" attr.type=\"string\"/>\n"
+                "<key id=\"link\" for=\"edge\" attr.name=\"link\" attr.type=\"string\"/>\n"
+                "<key id=\"pp\" for=\"edge\" attr.name=\"pp\" attr.type=\"boolean\"/>\n"
+                "<key id=\"ms\" for=\"edge\" attr.name=\"ms\" attr.type=\"string\"/>\n"
+                "<graph id=\"dbll\" edgedefault=\"directed\">\n", file);
+            break;
+        case EXPORT_BINARY:
+            fwrite("DBLLGRF1", 1, 8, file);
+            break;
+    }
+}
+
+static void exportFooter(struct exportCtx *ctx)
+{
+    switch (ctx->format)
+    {
+        case EXPORT_DOT:
+            fputs("}\n", ctx->file);
+            break;
+        case EXPORT_GRAPHML:
+            fputs("</graph>\n</graphml>\n", ctx->file);
+            break;
+        case EXPORT_BINARY:
+            putc('X', ctx->file);
+            break;
+    }
+}
+
+static void exportNode(struct exportCtx *ctx, const char *name, const char *rtype)
+{
+    FILE *file = ctx->file;
+
+    ctx->nodes++;
+    switch (ctx->format)
+    {
+        case EXPORT_DOT:
+            exportDotString(file, name);
+            if (rtype)
+            {
+                fputs(" [rtype=", file);
+                exportDotString(file, rtype);
+                fputs("];\n", file);
+            }
+            else
+                fputs(" [external=true, style=dashed];\n", file);
+            break;
+        case EXPORT_GRAPHML:
+            fputs("<node id=\"", file);
+            exportXmlString(file, name);
+            if (rtype)
+            {
+                fputs("\"><data key=\"rtype\">", file);
+                exportXmlString(file, rtype);
+                fputs("</data></node>\n", file);
+            }
+            else
+                fputs("\"><data key=\"external\">true</data></node>\n", file);
+            break;
+        case EXPORT_BINARY:
+            if (rtype && rtype != ctx->lastType)
+            {
+                putc('T', file);
+                exportBinString(file, rtype, 0);
+                ctx->lastType = rtype;
+            }
+            putc('N', file);
+            exportBinString(file, name, 0);
+            break;
+    }
+}
+
+static void exportLink(DBENTRY *pdbEntry, const char *symbol, void *arg)
+{
+    static const char *ltypes[] = { "in", "out", "fwd" };
+    static const char *msModes[] = { "NMS", "MS", "MSI", "MSS" };
+    struct exportCtx *ctx = arg;
+    FILE *file = ctx->file;
+    DBLINK *link;
+    const char *pvname;
+    const char *target;
+    const char *tfield;
+    const char *field;
+    char key[PVNAME_STRINGSZ];
+    size_t len;
+    int flags;
+
+    if (!symbol)
+    {
+        exportNode(ctx, dbGetRecordName(pdbEntry), dbGetRecordTypeName(pdbEntry));
+        return;
+    }
+
+    link = (DBLINK *)pdbEntry->pfield;
+    pvname = link->value.pv_link.pvname;
+    field = dbGetFieldName(pdbEntry);
+    flags = pdbEntry->pflddes->field_type == DBF_INLINK ? EXPORT_FLAG_IN :
+        pdbEntry->pflddes->field_type == DBF_OUTLINK ? EXPORT_FLAG_OUT : EXPORT_FLAG_FWD;
+    if (symbol[0] == 'p' || symbol[2] == 'p') flags |= EXPORT_FLAG_PP;
+    if (link->type == CA_LINK) flags |= EXPORT_FLAG_CA;
+    flags |= (link->value.pv_link.pvlMask & pvlOptMsMode) << EXPORT_FLAG_MS_SHIFT;
+
+    len = strcspn(pvname, ". ");
+    tfield = pvname[len] == '.' ? pvname + len + 1 : "";
+    if (len >= sizeof(key)) len = sizeof(key) - 1;
+    memcpy(key, pvname, len);
+    key[len] = 0;
+    if (dbFindRecord(&ctx->target, key) == 0)
+        target = ((dbCommon *)ctx->target.precnode->precord)->name;
+    else
+    {
+        target = key;
+        flags |= EXPORT_FLAG_EXTERN;
+        if (ctx->format != EXPORT_BINARY && !gphFind(ctx->external, key, ctx->external))
+        {
+            /* the hash only stores the pointer */
+            struct exportName *n = malloc(sizeof(struct exportName) + len);
+            if (n)
+            {
+                strcpy(n->name, key);
+                n->next = ctx->names;
+                ctx->names = n;
+                gphAdd(ctx->external, n->name, ctx->external);
+            }
+            exportNode(ctx, key, NULL);
+        }
+    }
+
+    ctx->edges++;
+    switch (ctx->format)
+    {
+        case EXPORT_DOT:
+            exportDotString(file, dbGetRecordName(pdbEntry));
+            fputs(" -> ", file);
+            exportDotString(file, target);
+            fprintf(file, " [field=\"%s\", tfield=", field);
+            exportDotString(file, tfield);
+            fprintf(file, ", ltype=%s, link=%s, pp=%d, ms=%s];\n",
+                ltypes[flags & 3], flags & EXPORT_FLAG_CA ? "ca" : "db",
+                !!(flags & EXPORT_FLAG_PP), msModes[(flags >> EXPORT_FLAG_MS_SHIFT) & 3]);
+            break;
+        case EXPORT_GRAPHML:
+            fputs("<edge source=\"", file);
+            exportXmlString(file, dbGetRecordName(pdbEntry));
+            fputs("\" target=\"", file);
+            exportXmlString(file, target);
+            fprintf(file, "\"><data key=\"field\">%s</data><data key=\"tfield\">", field);
+            exportXmlString(file, tfield);
+            fprintf(file, "</data><data key=\"ltype\">%s</data><data key=\"link\">%s</data>"
+                "<data key=\"pp\">%s</data><data key=\"ms\">%s</data></edge>\n",
+                ltypes[flags & 3], flags & EXPORT_FLAG_CA ? "ca" : "db",
+                flags & EXPORT_FLAG_PP ? "true" : "false",
+                msModes[(flags >> EXPORT_FLAG_MS_SHIFT) & 3]);
+            break;
+        case EXPORT_BINARY:
+            putc('E', file);
+            putc(flags, file);
+            exportBinString(file, field, 0);
+            len = strlen(target) + (*tfield ? strlen(tfield) + 1 : 0);
+            if (len > 0xffff) len = 0xffff;
+            putc(len & 0xff, file);
+            putc((len >> 8) & 0xff, file);
+            fputs(target, file);
+            if (*tfield)
+            {
+                putc('.', file);
+                fputs(tfield, file);
+            }
+            break;
+    }
+}
+
+static int exportFormat(const char *filename, const char *format)
+{
+    if (!format || !*format)
+    {
+        format = strrchr(filename, '.');
+        if (!format) return EXPORT_DOT;
+        format++;
+    }
+    if (epicsStrCaseCmp(format, "dot") == 0 || epicsStrCaseCmp(format, "gv") == 0)
+        return EXPORT_DOT;
+    if (epicsStrCaseCmp(format, "graphml") == 0 || epicsStrCaseCmp(format, "xml") == 0)
+        return EXPORT_GRAPHML;
+    if (epicsStrCaseCmp(format, "bin") == 0 || epicsStrCaseCmp(format, "binary") == 0)
+        return EXPORT_BINARY;
+    return -1;
+}
+
+long dbllExport(const char *filename, const char *format)
+{
+    struct exportCtx ctx;
+
+    if (!filename || !*filename)
+    {
+        fprintf(stderr, "usage: dbllExport file [dot|graphml|bin]\n");
+        return -1;
+    }
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.format = exportFormat(filename, format);
+    if (ctx.format < 0)
+    {
+        fprintf(stderr, "dbllExport: unknown format %s, use dot, graphml or bin\n", format);
+        return -1;
+    }
+    ctx.file = fopen(filename, ctx.format == EXPORT_BINARY ? "wb" : "w");
+    if (!ctx.file)
+    {
+        fprintf(stderr, "Can't open %s for writing: %s\n",
+            filename, strerror(errno));
+        return errno;
+    }
+    setvbuf(ctx.file, NULL, _IOFBF, EXPORT_BUFFER_SIZE);
+    gphInitPvt(&ctx.external, 256);
+    dbInitEntry(pdbbase, &ctx.target);
+
+    exportHeader(&ctx);
+    dbllForEachLink(DBLL_IMASK|DBLL_OMASK|DBLL_FMASK|DBLL_CMASK|DBLL_DMASK|DBLL_RMASK,
+        exportLink, &ctx);
+    exportFooter(&ctx);
+
+    dbFinishEntry(&ctx.target);
+    gphFreeMem(ctx.external);
+    while (ctx.names)
+    {
+        struct exportName *n = ctx.names;
+        ctx.names = n->next;
+        free(n);
+    }
+    if (fclose(ctx.file) != 0)
+    {
+        fprintf(stderr, "dbllExport: error writing %s: %s\n",
+            filename, strerror(errno));
+        return errno;
+    }
+    printf("%lu nodes, %lu links written to %s\n", ctx.nodes, ctx.edges, filename);
+    return 0;
+}
+
+static const iocshFuncDef dbllExportDef =
+    { "dbllExport", 2, (const iocshArg *[]) {
+    &(iocshArg) { "file", iocshArgString },
+    &(iocshArg) { "format [dot|graphml|bin]", iocshArgString },
+}};
+
+/*
+    dbllExport: Write the record link graph to a file
+
+    All records are nodes, all database and channel access links are
+    edges from the record owning the link to the target record, with
+    link field, target field, direction, PP and MS flags as attributes.
+    Targets outside this IOC are added as nodes marked external.
+
+    The graph is streamed in one pass through the database with a
+    fixed size output buffer.
+
+    Format: dot (graphviz), graphml or bin (see comment in dbllExport.c)
+        default is taken from the file name extension, else dot
+*/
+
+void dbllExportFunc(const iocshArgBuf *args)
+{
+    dbllExport(args[0].sval, args[1].sval);
+}
+
+static void dbllExportRegistrar(void)
+{
+    iocshRegister(&dbllExportDef, dbllExportFunc);
+}
+
+epicsExportRegistrar(dbllExportRegistrar);
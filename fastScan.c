@@ -0,0 +1,466 @@
+/* fastScan.c
+*
+*  process event scanned records at high rates from a timer thread
+*
+* Copyright (C) 2026 Dirk Zimoch
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <errno.h>
+#include "dbStaticLib.h"
+#include "dbAccess.h"
+#include "dbCommon.h"
+#include "dbScan.h"
+#include "dbLock.h"
+#include "epicsThread.h"
+#include "epicsMutex.h"
+#include "epicsEvent.h"
+#include "epicsString.h"
+#include "initHooks.h"
+#include "epicsStdioRedirect.h"
+#include "iocsh.h"
+#include "epicsExport.h"
+
+#include "threads.h"
+#include "fastScan.h"
+
+#ifdef __linux__
+#include <stdint.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/timerfd.h>
+#define FASTSCAN_TIMERFD
+#endif
+
+/*
+    Each fastScan has a thread waiting on a timerfd with absolute
+    deadlines: the kernel keeps the period, thus the processing time
+    does not add up and a late tick does not shift the following ones.
+    Expirations missed because processing took longer than a period
+    are counted as overruns and skipped, not caught up.
+
+    The thread processes the records with SCAN "Event" and the event
+    name in EVNT itself, ordered by PHAS, like a scan list does but
+    without the callback queue in between. The records are collected
+    when the ioc starts, records switched to the event later are not
+    seen. Nothing posts the event, so these records are not processed
+    by the standard event mechanism (unless something else posts it).
+    Device support can use fastScanIoScan() for I/O Intr records.
+*/
+
+struct fastScanRecord {
+    dbCommon *precord;
+    size_t seq;
+};
+
+struct fastScan {
+    struct fastScan *next;
+    char event[40];
+    double rate;
+    int align;
+    IOSCANPVT ioscan;
+    epicsThreadId tid;
+    epicsEventId started;
+    epicsMutexId lock;
+    int fd;
+    int running;
+    struct fastScanRecord *records;
+    size_t nrecords;
+    /* timer settings, under lock */
+    long long start, period;        /* ns of the timer clock */
+    unsigned long generation;
+    /* statistics since the timer was set */
+    unsigned long long ticks, overruns;
+    double lateSum, lateMax;        /* us after deadline */
+    double cycleSum, cycleMax;      /* us processing */
+};
+
+static struct fastScan *fastScanList;
+static int fastScanIocRunning;
+
+#ifdef FASTSCAN_TIMERFD
+static int fastScanEventMatch(const char *evnt, const char *event)
+{
+    char *end1, *end2;
+    double a, b;
+
+    while (isspace((unsigned char)*evnt)) evnt++;
+    if (strcmp(evnt, event) == 0) return 1;
+    /* numeric events: "5" and "5.0" are the same */
+    a = strtod(evnt, &end1);
+    b = strtod(event, &end2);
+    return end1 != evnt && !*end1 && end2 != event && !*end2 && a == b;
+}
+
+static int fastScanCompare(const void *a, const void *b)
+{
+    const struct fastScanRecord *ra = a, *rb = b;
+
+    if (ra->precord->phas != rb->precord->phas)
+        return ra->precord->phas < rb->precord->phas ? -1 : 1;
+    return ra->seq < rb->seq ? -1 : ra->seq > rb->seq;
+}
+
+static void fastScanCollect(struct fastScan *fs)
+{
+    DBENTRY dbEntry;
+    long status;
+    size_t n = 0, size = 0;
+
+    dbInitEntry(pdbbase, &dbEntry);
+    for (status = dbFirstRecordType(&dbEntry); !status; status = dbNextRecordType(&dbEntry))
+    for (status = dbFirstRecord(&dbEntry); !status; status = dbNextRecord(&dbEntry))
+    {
+        dbCommon *precord = dbEntry.precnode->precord;
+
+#ifdef DBRN_FLAGS_ISALIAS
+        if (dbIsAlias(&dbEntry)) continue;
+#endif
+        if (precord->scan != SCAN_EVENT) continue;
+        if (dbFindField(&dbEntry, "EVNT") != 0) continue;
+        if (!fastScanEventMatch(dbGetString(&dbEntry), fs->event)) continue;
+        if (n == size)
+        {
+            struct fastScanRecord *records;
+
+            size = size ? size * 2 : 64;
+            records = realloc(fs->records, size * sizeof(struct fastScanRecord));
+            if (!records)
+            {
+                fprintf(stderr, "fastScan %s: out of memory\n", fs->event);
+                break;
+            }
+            fs->records = records;
+        }
+        fs->records[n].precord = precord;
+        fs->records[n].seq = n;
+        n++;
+    }
+    dbFinishEntry(&dbEntry);
+    qsort(fs->records, n, sizeof(struct fastScanRecord), fastScanCompare);
+    fs->nrecords = n;
+    if (n == 0 && !fs->ioscan)
+        fprintf(stderr, "fastScan %s: no records with SCAN=Event and EVNT=%s\n",
+            fs->event, fs->event);
+}
+
+static long long fastScanNow(struct fastScan *fs)
+{
+    struct timespec now;
+
+    clock_gettime(fs->align ? CLOCK_REALTIME : CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/* (re)start the timer with the first deadline on a multiple of the
+   period, which is a wall clock boundary with align, or stop it,
+   called with fs->lock held */
+static int fastScanArm(struct fastScan *fs)
+{
+    struct itimerspec its;
+    long long period = 0, start = 0;
+
+    memset(&its, 0, sizeof(its));
+    if (fs->rate > 0)
+    {
+        period = (long long)(1e9 / fs->rate + 0.5);
+        start = (fastScanNow(fs) / period + 1) * period;
+        its.it_value.tv_sec = start / 1000000000;
+        its.it_value.tv_nsec = start % 1000000000;
+        its.it_interval.tv_sec = period / 1000000000;
+        its.it_interval.tv_nsec = period % 1000000000;
+    }
+    fs->start = start;
+    fs->period = period;
+    fs->generation++;
+    if (timerfd_settime(fs->fd, TFD_TIMER_ABSTIME, &its, NULL) != 0)
+    {
+        fprintf(stderr, "fastScan %s: can't set timer: %s\n", fs->event, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+static void fastScanThread(void *arg)
+{
+    struct fastScan *fs = arg;
+    long long start = 0, period = 0, t0, t1;
+    unsigned long generation = 0;
+    unsigned long long n = 0;
+    uint64_t expirations;
+    double late, cycle;
+    size_t i;
+
+    if (!fastScanIocRunning) epicsEventMustWait(fs->started);
+    fastScanCollect(fs);
+    epicsMutexMustLock(fs->lock);
+    fs->running = 1;
+    fastScanArm(fs);
+    epicsMutexUnlock(fs->lock);
+    while (1)
+    {
+        if (read(fs->fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+        {
+            if (errno == EINTR) continue;
+            fprintf(stderr, "fastScan %s: timer failed: %s\n", fs->event, strerror(errno));
+            break;
+        }
+        t0 = fastScanNow(fs);
+        epicsMutexMustLock(fs->lock);
+        if (fs->generation != generation)
+        {
+            generation = fs->generation;
+            start = fs->start;
+            period = fs->period;
+            fs->ticks = fs->overruns = 0;
+            fs->lateSum = fs->lateMax = fs->cycleSum = fs->cycleMax = 0;
+            /* the expirations may belong to the old or the new timer setting:
+               do not count them, take the tick number from the clock instead */
+            n = period && t0 >= start ? (t0 - start) / period + 1 : 0;
+            expirations = 0;
+        }
+        epicsMutexUnlock(fs->lock);
+        if (!period) continue;
+
+        for (i = 0; i < fs->nrecords; i++)
+        {
+            dbCommon *precord = fs->records[i].precord;
+
+            if (precord->scan != SCAN_EVENT) continue;
+            dbScanLock(precord);
+            dbProcess(precord);
+            dbScanUnlock(precord);
+        }
+        if (fs->ioscan) scanIoRequest(fs->ioscan);
+        if (!expirations) continue;
+
+        n += expirations;
+        t1 = fastScanNow(fs);
+        late = (t0 - (start + (long long)(n - 1) * period)) * 1e-3;
+        cycle = (t1 - t0) * 1e-3;
+        epicsMutexMustLock(fs->lock);
+        if (fs->generation == generation)
+        {
+            fs->ticks++;
+            fs->overruns += expirations - 1;
+            fs->lateSum += late;
+            if (late > fs->lateMax) fs->lateMax = late;
+            fs->cycleSum += cycle;
+            if (cycle > fs->cycleMax) fs->cycleMax = cycle;
+        }
+        epicsMutexUnlock(fs->lock);
+    }
+}
+#endif
+
+static struct fastScan *fastScanFind(const char *event, int create)
+{
+    struct fastScan *fs, **pnext;
+
+    for (pnext = &fastScanList; (fs = *pnext) != NULL; pnext = &fs->next)
+        if (strcmp(fs->event, event) == 0) return fs;
+    if (!create) return NULL;
+    if (strlen(event) >= sizeof(fs->event))
+    {
+        fprintf(stderr, "fastScan: event name \"%s\" too long\n", event);
+        return NULL;
+    }
+    fs = calloc(1, sizeof(struct fastScan));
+    if (!fs)
+    {
+        fprintf(stderr, "fastScan: out of memory\n");
+        return NULL;
+    }
+    strcpy(fs->event, event);
+    fs->fd = -1;
+    fs->lock = epicsMutexMustCreate();
+    fs->started = epicsEventMustCreate(epicsEventEmpty);
+    *pnext = fs;
+    return fs;
+}
+
+IOSCANPVT fastScanIoScan(const char *event)
+{
+    struct fastScan *fs = fastScanFind(event, 1);
+
+    if (!fs) return NULL;
+    if (!fs->ioscan) scanIoInit(&fs->ioscan);
+    return fs->ioscan;
+}
+
+long fastScan(double rate, const char *event, const char *priostr, const char *cpulist, int align)
+{
+#ifdef FASTSCAN_TIMERFD
+    struct fastScan *fs;
+    int priority = epicsThreadPriorityMax;
+    char threadname[16];
+
+    if (rate < 0 || rate > 1e6)
+    {
+        fprintf(stderr, "fastScan: rate %g Hz out of range\n", rate);
+        return -1;
+    }
+    if (!event || !*event) event = "fastScan";
+    if (priostr && *priostr)
+    {
+        priority = threadsStrToPrio(priostr, 0);
+        if (priority < 0) return -1;
+    }
+    fs = fastScanFind(event, 0);
+    if (rate == 0 && (!fs || fs->fd < 0))
+    {
+        fprintf(stderr, "fastScan %s: not started\n", event);
+        return -1;
+    }
+    if (!fs) fs = fastScanFind(event, 1);
+    if (!fs) return -1;
+    if (fs->fd >= 0 && !!align != fs->align)
+    {
+        fprintf(stderr, "fastScan %s: can't change alignment once started\n", event);
+        return -1;
+    }
+    if (fs->fd < 0)
+    {
+        fs->rate = rate;
+        fs->align = !!align;
+        fs->fd = timerfd_create(fs->align ? CLOCK_REALTIME : CLOCK_MONOTONIC, TFD_CLOEXEC);
+        if (fs->fd < 0)
+        {
+            fprintf(stderr, "fastScan %s: can't create timer: %s\n", event, strerror(errno));
+            return -1;
+        }
+        epicsSnprintf(threadname, sizeof(threadname), "fast%s", event);
+        fs->tid = epicsThreadCreate(threadname, priority,
+            epicsThreadGetStackSize(epicsThreadStackBig), fastScanThread, fs);
+        if (!fs->tid)
+        {
+            fprintf(stderr, "fastScan %s: can't create thread\n", event);
+            close(fs->fd);
+            fs->fd = -1;
+            return -1;
+        }
+        if (fastScanIocRunning) epicsEventSignal(fs->started);
+    }
+    else
+    {
+        if (priostr && *priostr) epicsThreadSetPriority(fs->tid, priority);
+        /* the thread arms the timer itself when it starts */
+        epicsMutexMustLock(fs->lock);
+        fs->rate = rate;
+        if (fs->running) fastScanArm(fs);
+        epicsMutexUnlock(fs->lock);
+    }
+    if (cpulist && *cpulist) threadsSetAffinityList(fs->tid, cpulist);
+    return 0;
+#else
+    fprintf(stderr, "fastScan: needs timerfd (Linux only)\n");
+    return -1;
+#endif
+}
+
+void fastScanReport(void)
+{
+    struct fastScan *fs;
+
+    if (!fastScanList)
+    {
+        printf("no fastScan configured\n");
+        return;
+    }
+    printf("%-20s %9s %7s %12s %9s %10s %10s %10s %10s\n", "event", "rate/Hz", "records",
+        "ticks", "overruns", "late/us", "max", "cycle/us", "max");
+    for (fs = fastScanList; fs; fs = fs->next)
+    {
+        unsigned long long ticks, overruns;
+        double rate, lateSum, lateMax, cycleSum, cycleMax;
+
+        /* 64 bit counters and doubles may tear on 32 bit systems */
+        epicsMutexMustLock(fs->lock);
+        rate = fs->rate;
+        ticks = fs->ticks;
+        overruns = fs->overruns;
+        lateSum = fs->lateSum;
+        lateMax = fs->lateMax;
+        cycleSum = fs->cycleSum;
+        cycleMax = fs->cycleMax;
+        epicsMutexUnlock(fs->lock);
+        printf("%-20s %9g %7lu %12llu %9llu %10.1f %10.1f %10.1f %10.1f%s\n",
+            fs->event, rate, (unsigned long)fs->nrecords, ticks, overruns,
+            lateSum / (ticks ? ticks : 1), lateMax, cycleSum / (ticks ? ticks : 1), cycleMax,
+            fs->align ? " aligned" : "");
+    }
+}
+
+static void fastScanInitHook(initHookState state)
+{
+    struct fastScan *fs;
+
+    if (state != initHookAfterIocRunning) return;
+    fastScanIocRunning = 1;
+    for (fs = fastScanList; fs; fs = fs->next)
+        if (fs->tid) epicsEventSignal(fs->started);
+}
+
+static const iocshFuncDef fastScanDef =
+    { "fastScan", 5, (const iocshArg *[]) {
+    &(iocshArg) { "rate/Hz", iocshArgDouble },
+    &(iocshArg) { "event", iocshArgString },
+    &(iocshArg) { "priority", iocshArgString },
+    &(iocshArg) { "cpulist", iocshArgString },
+    &(iocshArg) { "align", iocshArgInt },
+}};
+
+/*
+    fastScan: Process event scanned records from a high rate timer
+
+    Processes all records with SCAN "Event" and EVNT = event (default
+    "fastScan") in PHAS order rate times per second in a thread of the
+    given priority (default Max) and cpu affinity. With align = 1 the
+    ticks are aligned to the wall clock (e.g. full milliseconds for
+    1000 Hz), otherwise the monotonic clock is used.
+    Calling it again changes rate, priority and affinity, rate 0 stops.
+    Linux only.
+*/
+
+void fastScanFunc(const iocshArgBuf *args)
+{
+    fastScan(args[0].dval, args[1].sval, args[2].sval, args[3].sval, args[4].ival);
+}
+
+static const iocshFuncDef fastScanReportDef = { "fastScanReport", 0, NULL };
+
+/*
+    fastScanReport: Show statistics of all fastScans
+
+    Shows the number of ticks, missed ticks (overruns), mean and maximum
+    wake up latency and processing time since the rate was last set.
+*/
+
+void fastScanReportFunc(const iocshArgBuf *args)
+{
+    fastScanReport();
+}
+
+static void fastScanRegistrar(void)
+{
+    iocshRegister(&fastScanDef, fastScanFunc);
+    iocshRegister(&fastScanReportDef, fastScanReportFunc);
+    initHookRegister(fastScanInitHook);
+}
+
+epicsExportRegistrar(fastScanRegistrar);
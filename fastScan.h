@@ -0,0 +1,19 @@
+#ifndef fastScan_h
+#define fastScan_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "dbScan.h"
+
+/* I/O Intr scan list triggered on every tick of the fastScan with this
+   event name, for device support get_ioint_info. Can be called before
+   fastScan has been configured. Returns NULL on error. */
+IOSCANPVT fastScanIoScan(const char *event);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,173 @@
+/* globBenchmark.c
+*
+*  compare the compiled glob matcher with epicsStrGlobMatch
+*
+* Copyright (C) 2026 Dirk Zimoch
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+#include <stdlib.h>
+#include "dbStaticLib.h"
+#include "dbAccess.h"
+#include "epicsString.h"
+#include "epicsTime.h"
+#include "iocsh.h"
+#include "epicsStdioRedirect.h"
+#include "epicsExport.h"
+
+#include "globMatch.h"
+
+#define SYNTHETIC_NAMES 200000
+#define MIN_MATCHES 2000000
+
+/* record names of the loaded database or synthetic names following a naming convention */
+static char **globBenchmarkNames(size_t *count, int *synthetic)
+{
+    static const char *sections[] = { "ARIDI", "ARS01", "SINEG01", "S10CB02", "SATUN07", "SARFE10" };
+    static const char *devices[] = { "BPM", "PS", "VAC", "MAG", "RF", "DBPM" };
+    static const char *signals[] = { "X-AVG", "Y-AVG", "I-SET", "I-READ", "STATUS", "PRES", "TEMP", "ON-OFF" };
+    DBENTRY dbEntry;
+    long status;
+    char **names;
+    size_t n = 0, i;
+
+    if (pdbbase)
+    {
+        dbInitEntry(pdbbase, &dbEntry);
+        for (status = dbFirstRecordType(&dbEntry); !status; status = dbNextRecordType(&dbEntry))
+            n += dbGetNRecords(&dbEntry);
+    }
+    if (n)
+    {
+        names = malloc(n * sizeof(char *));
+        if (!names) return NULL;
+        i = 0;
+        for (status = dbFirstRecordType(&dbEntry); !status; status = dbNextRecordType(&dbEntry))
+        for (status = dbFirstRecord(&dbEntry); !status && i < n; status = dbNextRecord(&dbEntry))
+            names[i++] = dbGetRecordName(&dbEntry);
+        dbFinishEntry(&dbEntry);
+        *count = i;
+        *synthetic = 0;
+        return names;
+    }
+    if (pdbbase) dbFinishEntry(&dbEntry);
+
+    n = SYNTHETIC_NAMES;
+    names = malloc(n * sizeof(char *));
+    if (!names) return NULL;
+    for (i = 0; i < n; i++)
+    {
+        char buffer[64];
+        sprintf(buffer, "%s-%s%u-%s%02u:%s",
+            sections[i % 6], devices[(i / 6) % 6], (unsigned)(i / 36) % 10,
+            (i / 360) % 2 ? "LE" : "RI", (unsigned)(i / 720) % 100, signals[(i / 7) % 8]);
+        names[i] = epicsStrDup(buffer);
+    }
+    *count = n;
+    *synthetic = 1;
+    return names;
+}
+
+static double globBenchmarkRun(char **names, size_t count, int reps,
+    const char *pattern, const globMatcher *matcher, size_t *matches)
+{
+    epicsTimeStamp start, end;
+    size_t i, n = 0;
+    int r;
+
+    epicsTimeGetCurrent(&start);
+    for (r = 0; r < reps; r++)
+    {
+        n = 0;
+        if (matcher)
+        {
+            for (i = 0; i < count; i++)
+                if (globMatch(matcher, names[i])) n++;
+        }
+        else
+        {
+            for (i = 0; i < count; i++)
+                if (epicsStrGlobMatch(names[i], pattern)) n++;
+        }
+    }
+    epicsTimeGetCurrent(&end);
+    *matches = n;
+    return epicsTimeDiffInSeconds(&end, &start) * 1e9 / ((double)count * reps);
+}
+
+void globBenchmark(const char **patterns)
+{
+    static const char *defaultPatterns[] = {
+        "*", "ARIDI-BPM3-LE07:X-AVG", "ARIDI-*", "*:I-SET", "*BPM*X-AVG",
+        "S??CB*", "*-VAC?-*:PRES", "*DBPM*RI*:*-AVG", NULL };
+    char **names;
+    size_t count = 0, i;
+    int reps, synthetic = 0;
+
+    names = globBenchmarkNames(&count, &synthetic);
+    if (!names || !count)
+    {
+        fprintf(stderr, "globBenchmark: no names\n");
+        free(names);
+        return;
+    }
+    if (!patterns || !*patterns) patterns = defaultPatterns;
+    reps = (int)(MIN_MATCHES / count) + 1;
+    printf("%lu %s names, %d repetitions\n", (unsigned long)count,
+        synthetic ? "synthetic" : "record", reps);
+    printf("%-24s %8s %10s %10s %8s\n", "pattern", "matches", "glob ns", "compiled", "speedup");
+    for (; *patterns; patterns++)
+    {
+        globMatcher *matcher = globCompile(*patterns);
+        size_t n1, n2;
+        double t1, t2;
+
+        t1 = globBenchmarkRun(names, count, reps, *patterns, NULL, &n1);
+        t2 = globBenchmarkRun(names, count, reps, *patterns, matcher, &n2);
+        printf("%-24s %8lu %10.1f %10.1f %7.1fx%s\n", *patterns, (unsigned long)n1,
+            t1, t2, t2 > 0 ? t1 / t2 : 0.0, n1 != n2 ? " MISMATCH" : "");
+        globFree(matcher);
+    }
+    if (synthetic)
+        for (i = 0; i < count; i++) free(names[i]);
+    free(names);
+}
+
+static const iocshFuncDef globBenchmarkDef =
+    { "globBenchmark", 1, (const iocshArg *[]) {
+    &(iocshArg) { "pattern...", iocshArgArgv },
+}};
+
+/*
+    globBenchmark: Compare compiled glob patterns with epicsStrGlobMatch
+
+    Matches all record names of the loaded database (or 200000 synthetic
+    names if no database is loaded) against each pattern with both
+    methods and prints the time per name. Without arguments a set of
+    typical patterns is used.
+*/
+
+void globBenchmarkFunc(const iocshArgBuf *args)
+{
+    globBenchmark((const char **)args[0].aval.av + 1);
+}
+
+static void globBenchmarkRegistrar(void)
+{
+    iocshRegister(&globBenchmarkDef, globBenchmarkFunc);
+}
+
+epicsExportRegistrar(globBenchmarkRegistrar);
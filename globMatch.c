@@ -0,0 +1,225 @@
+/* globMatch.c
+*
+*  compiled glob patterns for the list commands
+*
+* Copyright (C) 2026 Dirk Zimoch
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "globMatch.h"
+
+/*
+    A pattern is split at '*' into literal segments (which may contain '?').
+    Without '*' the string must have exactly the length of the pattern.
+    Otherwise the first segment is an anchored prefix, the last one an
+    anchored suffix and the segments in between must be found in order.
+    Leftmost matching of each middle segment is sufficient because '*'
+    matches anything. Middle segments are located with memchr on their
+    first literal character which uses the vectorized libc routine.
+*/
+
+struct globSegment {
+    const char *text;
+    size_t len;
+    size_t anchor;              /* offset of first literal char or len if only '?' */
+    int wild;                   /* contains '?' */
+};
+
+struct globPattern {
+    size_t minlen;
+    int star;                   /* contains '*' */
+    int nseg;
+    struct globSegment *seg;
+};
+
+struct globMatcher {
+    int n;
+    int all;                    /* one of the patterns is "*" */
+    struct globPattern *pattern;
+};
+
+static int globSegmentEqual(const char *s, const struct globSegment *seg)
+{
+    size_t i;
+
+    if (!seg->wild) return memcmp(s, seg->text, seg->len) == 0;
+    for (i = 0; i < seg->len; i++)
+        if (seg->text[i] != '?' && seg->text[i] != s[i]) return 0;
+    return 1;
+}
+
+/* leftmost occurrence of seg in [s, end) */
+static const char *globSegmentFind(const char *s, const char *end, const struct globSegment *seg)
+{
+    const char *last = end - seg->len;   /* last possible start */
+    const char *r;
+
+    if (s > last) return NULL;
+    if (seg->anchor == seg->len) return s;
+    while (s <= last)
+    {
+        r = memchr(s + seg->anchor, seg->text[seg->anchor], last - s + 1);
+        if (!r) return NULL;
+        s = r - seg->anchor;
+        if (globSegmentEqual(s, seg)) return s;
+        s++;
+    }
+    return NULL;
+}
+
+/* anchored prefix, also stops at the end of a shorter string */
+static int globPrefixEqual(const char *s, const struct globSegment *seg)
+{
+    size_t i;
+
+    if (!seg->wild)
+    {
+        /* a shorter string fails at its terminating null byte */
+        for (i = 0; i < seg->len; i++)
+            if (seg->text[i] != s[i]) return 0;
+        return 1;
+    }
+    for (i = 0; i < seg->len; i++)
+        if (!s[i] || (seg->text[i] != '?' && seg->text[i] != s[i])) return 0;
+    return 1;
+}
+
+/* string length is only computed when needed and then shared by all patterns */
+static int globPatternMatch(const struct globPattern *p, const char *str, size_t *plen)
+{
+    const struct globSegment *first, *last;
+    const char *s, *end;
+    size_t len;
+    int i;
+
+    first = &p->seg[0];
+    if (!globPrefixEqual(str, first)) return 0;
+    if (!p->star) return str[first->len] == 0;
+    last = &p->seg[p->nseg - 1];
+    if (p->nseg == 2 && last->len == 0) return 1;   /* prefix* */
+    if (*plen == (size_t)-1) *plen = strlen(str);
+    len = *plen;
+    if (len < p->minlen) return 0;
+    if (!globSegmentEqual(str + len - last->len, last)) return 0;
+    s = str + first->len;
+    end = str + len - last->len;
+    for (i = 1; i < p->nseg - 1; i++)
+    {
+        s = globSegmentFind(s, end, &p->seg[i]);
+        if (!s) return 0;
+        s += p->seg[i].len;
+    }
+    return 1;
+}
+
+static size_t globCountSegments(const char *pattern)
+{
+    size_t n = 1;
+    for (; *pattern; pattern++)
+        if (*pattern == '*') n++;
+    return n;
+}
+
+static void globCompilePattern(struct globPattern *p, struct globSegment *seg, char *text)
+{
+    char *star;
+
+    p->seg = seg;
+    p->nseg = 0;
+    p->minlen = 0;
+    p->star = strchr(text, '*') != NULL;
+    while (1)
+    {
+        star = strchr(text, '*');
+        seg->text = text;
+        seg->len = star ? (size_t)(star - text) : strlen(text);
+        seg->anchor = strspn(text, "?");
+        if (seg->anchor > seg->len) seg->anchor = seg->len;
+        seg->wild = memchr(text, '?', seg->len) != NULL;
+        p->minlen += seg->len;
+        /* empty middle segments from ** need no search */
+        if (seg->len || p->nseg == 0 || !star)
+        {
+            p->nseg++;
+            seg++;
+        }
+        if (!star) break;
+        text = star + 1;
+    }
+}
+
+globMatcher *globCompileList(const char *const *patternlist)
+{
+    globMatcher *m;
+    struct globSegment *seg;
+    size_t npat = 0, nseg = 0, size = 0;
+    char *text;
+    int i;
+
+    if (patternlist)
+        for (; patternlist[npat]; npat++)
+        {
+            nseg += globCountSegments(patternlist[npat]);
+            size += strlen(patternlist[npat]) + 1;
+        }
+    m = malloc(sizeof(globMatcher) + npat * sizeof(struct globPattern) +
+        nseg * sizeof(struct globSegment) + size);
+    if (!m) return NULL;
+    m->n = (int)npat;
+    m->all = npat == 0;
+    m->pattern = (struct globPattern *)(m + 1);
+    seg = (struct globSegment *)(m->pattern + npat);
+    text = (char *)(seg + nseg);
+    for (i = 0; i < m->n; i++)
+    {
+        size_t l = strlen(patternlist[i]);
+        memcpy(text, patternlist[i], l + 1);
+        if (strspn(text, "*") == l && l > 0) m->all = 1;
+        globCompilePattern(&m->pattern[i], seg, text);
+        seg += m->pattern[i].nseg;
+        text += l + 1;
+    }
+    return m;
+}
+
+globMatcher *globCompile(const char *pattern)
+{
+    const char *patternlist[2];
+
+    patternlist[0] = pattern;
+    patternlist[1] = NULL;
+    return globCompileList(patternlist);
+}
+
+int globMatch(const globMatcher *m, const char *str)
+{
+    size_t len;
+    int i;
+
+    if (!m || m->all) return 1;
+    if (!str) return 0;
+    len = (size_t)-1;
+    for (i = 0; i < m->n; i++)
+        if (globPatternMatch(&m->pattern[i], str, &len)) return 1;
+    return 0;
+}
+
+void globFree(globMatcher *m)
+{
+    free(m);
+}
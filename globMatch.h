@@ -0,0 +1,23 @@
+#ifndef globMatch_h
+#define globMatch_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Compiled glob pattern with the syntax of epicsStrGlobMatch (* and ?).
+   A matcher can hold several patterns and matches if any of them does.
+   A NULL matcher or a matcher without patterns matches everything. */
+
+typedef struct globMatcher globMatcher;
+
+globMatcher *globCompile(const char *pattern);
+globMatcher *globCompileList(const char *const *patternlist);  /* NULL terminated */
+int globMatch(const globMatcher *matcher, const char *str);
+void globFree(globMatcher *matcher);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
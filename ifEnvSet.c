@@ -3,6 +3,7 @@
 
 #include "envDefs.h"
 #include "epicsEnvUnset.h"
+#include "globMatch.h"
 
 #include "epicsVersion.h"
 #ifdef BASE_VERSION
@@ -24,37 +25,6 @@
 
 int ifEnvSetDebug;
 
-static int match(const char *str, const char *pattern)
-{
-    const char *cp = NULL, *mp = NULL;
-
-    while ((*str) && (*pattern != '*')) {
-        if ((*pattern != *str) && (*pattern != '?'))
-            return 0;
-        pattern++;
-        str++;
-    }
-    while (*str) {
-        if (*pattern == '*') {
-            if (!*++pattern)
-                return 1;
-            mp = pattern;
-            cp = str+1;
-        }
-        else if ((*pattern == *str) || (*pattern == '?')) {
-            pattern++;
-            str++;
-        }
-        else {
-            pattern = mp;
-            str = cp++;
-        }
-    }
-    while (*pattern == '*')
-        pattern++;
-    return !*pattern;
-}
-
 #ifdef EPICS_3_13
 static void epicsEnvSet(const char* variable, const char* value)
 {
@@ -126,8 +96,10 @@ int ifEnvSet(const char* arg, const char* condition, const char *variable, const
 cont:
     if (ifEnvSetDebug) printf ("CONDITION: '%s' ", condition);
     if (op & MATCH) {
+        globMatcher *matcher = globCompile(condition);
         if (ifEnvSetDebug) printf("<match branch MATCH='%s'> ", condition);
-        result |= match(arg, condition);
+        result |= globMatch(matcher, arg);
+        globFree(matcher);
     }
     num_condition = strtol(condition, &e, 0);
     if (ifEnvSetDebug) printf("parsed %ld ", num_condition);
@@ -0,0 +1,184 @@
+/* listOutput.c
+*
+*  JSON Lines and CSV output for the list commands
+*
+* Copyright (C) 2026 Dirk Zimoch
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include "epicsStdioRedirect.h"
+
+#include "listOutput.h"
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
+
+#define LIST_BUFFER_SIZE (1<<20)
+
+int listOutputArgs(struct listOutput *out, int argc, char **argv)
+{
+    int i;
+
+    memset(out, 0, sizeof(*out));
+    for (i = 0; i < argc && argv[i] && argv[i][0] == '-'; i++)
+    {
+        if (strcmp(argv[i], "-json") == 0)
+            out->format = LIST_JSON;
+        else if (strcmp(argv[i], "-csv") == 0)
+            out->format = LIST_CSV;
+        else if (strcmp(argv[i], "-o") == 0 && i+1 < argc && argv[i+1])
+            out->filename = argv[++i];
+        else
+            return -1;
+    }
+    return i;
+}
+
+int listOutputOpen(struct listOutput *out)
+{
+    if (!out->filename || !*out->filename) return 0;
+    if (out->filename[0] == '|')
+    {
+#ifdef vxWorks
+        fprintf(stderr, "Pipes not supported on vxWorks\n");
+        return -1;
+#else
+        out->file = popen(out->filename + 1, "w");
+#endif
+    }
+    else
+        out->file = fopen(out->filename, "w");
+    if (!out->file)
+    {
+        fprintf(stderr, "Can't open %s for writing: %s\n",
+            out->filename, strerror(errno));
+        return -1;
+    }
+    setvbuf(out->file, NULL, _IOFBF, LIST_BUFFER_SIZE);
+    out->oldStdout = epicsGetThreadStdout();
+    epicsSetThreadStdout(out->file);
+    return 0;
+}
+
+void listOutputClose(struct listOutput *out)
+{
+    if (!out->file) return;
+    epicsSetThreadStdout(out->oldStdout);
+#ifndef vxWorks
+    if (out->filename[0] == '|')
+        pclose(out->file);
+    else
+#endif
+        fclose(out->file);
+    out->file = NULL;
+}
+
+/* write runs of plain characters at once, escape the rest */
+static void listOutputJsonString(FILE *file, const char *s)
+{
+    const char *p;
+
+    putc('"', file);
+    if (s) while (*s)
+    {
+        for (p = s; *p && *p != '"' && *p != '\\' && (unsigned char)*p >= 0x20; p++);
+        if (p > s) fwrite(s, 1, p - s, file);
+        if (!*p) break;
+        switch (*p)
+        {
+            case '"':  fputs("\\\"", file); break;
+            case '\\': fputs("\\\\", file); break;
+            case '\n': fputs("\\n", file); break;
+            case '\r': fputs("\\r", file); break;
+            case '\t': fputs("\\t", file); break;
+            default:   fprintf(file, "\\u%04x", (unsigned char)*p);
+        }
+        s = p + 1;
+    }
+    putc('"', file);
+}
+
+static void listOutputCsvString(FILE *file, const char *s)
+{
+    const char *p;
+
+    if (!s) return;
+    if (!s[strcspn(s, ",\"\r\n")] && s[0] != ' ' && (s[0] == 0 || s[strlen(s)-1] != ' '))
+    {
+        fputs(s, file);
+        return;
+    }
+    putc('"', file);
+    while ((p = strchr(s, '"')) != NULL)
+    {
+        fwrite(s, 1, p - s + 1, file);
+        putc('"', file);
+        s = p + 1;
+    }
+    fputs(s, file);
+    putc('"', file);
+}
+
+void listOutputHeader(int format, int n, const char *const names[])
+{
+    FILE *file = stdout;
+    int i;
+
+    if (format != LIST_CSV) return;
+    for (i = 0; i < n; i++)
+    {
+        if (i) putc(',', file);
+        listOutputCsvString(file, names[i]);
+    }
+    putc('\n', file);
+}
+
+void listOutputRow(int format, int n, const char *const names[], const char *const values[])
+{
+    FILE *file = stdout;
+    int i;
+
+    switch (format)
+    {
+        case LIST_JSON:
+            putc('{', file);
+            for (i = 0; i < n; i++)
+            {
+                if (i) putc(',', file);
+                listOutputJsonString(file, names[i]);
+                putc(':', file);
+                listOutputJsonString(file, values[i]);
+            }
+            fputs("}\n", file);
+            break;
+        case LIST_CSV:
+            for (i = 0; i < n; i++)
+            {
+                if (i) putc(',', file);
+                listOutputCsvString(file, values[i]);
+            }
+            putc('\n', file);
+            break;
+        default:
+            for (i = 0; i < n; i++)
+                printf("%s%s", i ? " " : "", values[i] ? values[i] : "");
+            putc('\n', file);
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef listOutput_h
+#define listOutput_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+
+/* machine readable output for the list commands (dbli, dbla, dbll) */
+
+#define LIST_TEXT 0
+#define LIST_JSON 1     /* JSON Lines: one object per line */
+#define LIST_CSV  2     /* RFC 4180 with header line */
+
+struct listOutput {
+    int format;
+    const char *filename;       /* NULL: stdout, "|command": pipe */
+    FILE *file;
+    FILE *oldStdout;
+};
+
+/* Parse leading options -json, -csv, -o file.
+   Returns the number of arguments consumed or -1 on error. */
+int listOutputArgs(struct listOutput *out, int argc, char **argv);
+
+/* Redirect stdout of this thread to the file or pipe (if any) with a
+   large buffer. Returns 0 on success. */
+int listOutputOpen(struct listOutput *out);
+void listOutputClose(struct listOutput *out);
+
+/* Print header (CSV only) and rows of n columns to stdout. */
+void listOutputHeader(int format, int n, const char *const names[]);
+void listOutputRow(int format, int n, const char *const names[], const char *const values[]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
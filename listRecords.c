@@ -2,6 +2,8 @@
 *
 *  listRecords is a wrapper function for dbl 
 *  it hides the changed syntax of dbl between R3.13 and R3.14.
+*  Since R3.14 it can compress (file name ending in .gz) and run in
+*  the background.
 *
 * Copyright (C) 2007 Dirk Zimoch
 *
@@ -19,6 +21,9 @@
 * along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
 #include <stddef.h>
 #include <errno.h>
 #include "epicsVersion.h"
@@ -29,12 +34,109 @@ long dbl(char *precordTypename, char *filename, char *fields);
 #else
 #define EPICS_3_14
 #include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#ifdef WITH_ZLIB
+#include <zlib.h>
+#endif
 #include "dbTest.h"
+#include "dbAccess.h"
+#include "epicsThread.h"
+#include "epicsTime.h"
+#include "epicsString.h"
+#include "errlog.h"
 #include "epicsStdioRedirect.h"
 #include "iocsh.h"
 #include "epicsExport.h"
 #endif
 
+#ifdef EPICS_3_14
+#define LISTRECORDS_BUFFER_SIZE (1<<20)
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
+
+/*
+    Files ending in .gz are compressed while writing, with zlib if
+    available (Linux, built with WITH_ZLIB), else with a gzip pipe.
+*/
+
+#if defined(WITH_ZLIB) && defined(__linux__)
+static ssize_t listRecordsGzWrite(void *cookie, const char *buffer, size_t size)
+{
+    int n = gzwrite((gzFile)cookie, buffer, (unsigned int)size);
+    return n > 0 ? n : -1;
+}
+
+static int listRecordsGzClose(void *cookie)
+{
+    return gzclose((gzFile)cookie) == Z_OK ? 0 : EOF;
+}
+#endif
+
+static FILE* listRecordsOpen(const char* filename, int* isPipe)
+{
+    size_t len = strlen(filename);
+    FILE* file;
+
+    *isPipe = 0;
+    if (len > 3 && strcmp(filename + len - 3, ".gz") == 0)
+    {
+#if defined(WITH_ZLIB) && defined(__linux__)
+        cookie_io_functions_t gzFunctions = { NULL, listRecordsGzWrite, NULL, listRecordsGzClose };
+        gzFile gz = gzopen(filename, "wb");
+
+        if (!gz) return NULL;
+        gzbuffer(gz, LISTRECORDS_BUFFER_SIZE);
+        file = fopencookie(gz, "w", gzFunctions);
+        if (!file) gzclose(gz);
+#elif !defined(vxWorks)
+        /* quote for the shell, ' becomes '\'' */
+        char* command = malloc(4 * len + 16);
+        char* p;
+
+        if (!command) return NULL;
+        p = command + sprintf(command, "gzip -c > '");
+        for (; *filename; filename++)
+        {
+            if (*filename == '\'')
+            {
+                strcpy(p, "'\\''");
+                p += 4;
+            }
+            else *p++ = *filename;
+        }
+        strcpy(p, "'");
+        file = popen(command, "w");
+        free(command);
+        *isPipe = 1;
+#else
+        fprintf(stderr, "Compression not supported\n");
+        errno = ENOSYS;
+        return NULL;
+#endif
+    }
+    else
+        file = fopen(filename, "w");
+    if (file) setvbuf(file, NULL, _IOFBF, LISTRECORDS_BUFFER_SIZE);
+    return file;
+}
+
+static void listRecordsClose(FILE* file, int isPipe)
+{
+#ifndef vxWorks
+    if (isPipe)
+    {
+        pclose(file);
+        return;
+    }
+#endif
+    fclose(file);
+}
+#endif
+
 int listRecords(char* filename, char* fields)
 {
 #ifdef EPICS_3_13
@@ -43,10 +145,11 @@ int listRecords(char* filename, char* fields)
     {
         FILE* oldStdout = NULL;
         FILE* newStdout = NULL;
+        int isPipe = 0;
 
         if (filename && *filename)
         {
-            newStdout = fopen(filename, "w");
+            newStdout = listRecordsOpen(filename, &isPipe);
             if (!newStdout)
             {
                 fprintf(stderr, "Can't open %s for writing: %s\n",
@@ -59,22 +162,97 @@ int listRecords(char* filename, char* fields)
         dbl(0L, fields);
         if (newStdout)
         {
-            fclose(newStdout);
             epicsSetThreadStdout(oldStdout);
+            listRecordsClose(newStdout, isPipe);
         }
         return 0;
     }
 #endif
 }
 
+#ifdef EPICS_3_14
+/*
+    Background dumps run in a low priority thread. They are only allowed
+    after iocInit, when no records are loaded and iocInit does not change
+    links and other fields any more.
+*/
+
+struct listRecordsJob {
+    FILE* file;
+    int isPipe;
+    char* filename;
+    char* fields;
+};
+
+static void listRecordsThread(void* arg)
+{
+    struct listRecordsJob* job = arg;
+    epicsTimeStamp start, end;
+    FILE* oldStdout;
+
+    epicsTimeGetCurrent(&start);
+    /* restore a redirection when called directly from the shell */
+    oldStdout = epicsGetThreadStdout();
+    epicsSetThreadStdout(job->file);
+    dbl(0L, job->fields);
+    epicsSetThreadStdout(oldStdout);
+    listRecordsClose(job->file, job->isPipe);
+    epicsTimeGetCurrent(&end);
+    errlogPrintf("listRecords: %s written in %.1f s\n",
+        job->filename, epicsTimeDiffInSeconds(&end, &start));
+    free(job->filename);
+    free(job->fields);
+    free(job);
+}
+
+int listRecordsBackground(char* filename, char* fields)
+{
+    struct listRecordsJob* job;
+
+    if (!filename || !*filename)
+    {
+        fprintf(stderr, "listRecords: background needs a file name\n");
+        return -1;
+    }
+    if (!interruptAccept)
+    {
+        fprintf(stderr, "listRecords: background only after iocInit\n");
+        return -1;
+    }
+    job = calloc(1, sizeof(struct listRecordsJob));
+    if (!job) return ENOMEM;
+    job->file = listRecordsOpen(filename, &job->isPipe);
+    if (!job->file)
+    {
+        fprintf(stderr, "Can't open %s for writing: %s\n",
+            filename, strerror(errno));
+        free(job);
+        return errno;
+    }
+    job->filename = epicsStrDup(filename);
+    job->fields = fields ? epicsStrDup(fields) : NULL;
+    if (!epicsThreadCreate("listRecords", epicsThreadPriorityLow,
+        epicsThreadGetStackSize(epicsThreadStackMedium), listRecordsThread, job))
+    {
+        fprintf(stderr, "listRecords: can't create thread, writing %s now\n", filename);
+        listRecordsThread(job);
+    }
+    return 0;
+}
+#endif
+
 #ifdef EPICS_3_14
 static const iocshArg listRecordsArg0 = { "filename", iocshArgString };
 static const iocshArg listRecordsArg1 = { "fields", iocshArgString };
-static const iocshArg * const listRecordsArgs[2] = { &listRecordsArg0, &listRecordsArg1 };
-static const iocshFuncDef listRecordsDef = { "listRecords", 2, listRecordsArgs };
+static const iocshArg listRecordsArg2 = { "background", iocshArgInt };
+static const iocshArg * const listRecordsArgs[3] = { &listRecordsArg0, &listRecordsArg1, &listRecordsArg2 };
+static const iocshFuncDef listRecordsDef = { "listRecords", 3, listRecordsArgs };
 static void listRecordsFunc (const iocshArgBuf *args)
 {
-    listRecords(args[0].sval, args[1].sval);
+    if (args[2].ival)
+        listRecordsBackground(args[0].sval, args[1].sval);
+    else
+        listRecords(args[0].sval, args[1].sval);
 }
 static void listRecordsRegister(void)
 {
@@ -0,0 +1,186 @@
+/* optimizeLocalCaLinks.c
+*
+*  find channel access links to local records and turn them into database links
+*
+* Copyright (C) 2026 Dirk Zimoch
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include "dbStaticLib.h"
+#include "dbAccess.h"
+#include "dbCommon.h"
+#include "iocsh.h"
+#include "epicsStdioRedirect.h"
+#include "epicsExport.h"
+
+#include "dbll.h"
+
+/*
+    Before iocInit all links are still PV_LINK. A link becomes a CA link
+    at iocInit if it has the CA, CP or CPP flag or if the target is not
+    found in this IOC. Here only links with a flag and a local target are
+    handled, because links without flag to local records become database
+    links anyway.
+
+    The conversion keeps what the record sees of the link:
+    Input links: a CA get does not process the target -> NPP DB link.
+    Output links: a CA put processes a passive target if the field is
+        pp(TRUE) or PROC -> PP DB link in that case.
+    Forward links: a CA link writes PROC which processes the target
+        also if not passive, a DB forward link only processes passive
+        records -> only converted for passive targets.
+    CP and CPP links process the record on every monitor of the target,
+    which a DB link cannot do. They are reported but stay CA.
+*/
+
+struct optimizeContext {
+    DBENTRY target;
+    int convert;
+    int found;
+    int converted;
+    int kept;
+};
+
+/* check link target, return reason for keeping it as CA link or NULL */
+static const char *optimizeCheckTarget(struct optimizeContext *ctx, DBENTRY *pdbEntry, int *pp)
+{
+    DBLINK *link = (DBLINK *)pdbEntry->pfield;
+    char recordname[256];
+    const char *field;
+    const char *p;
+    dbCommon *precord;
+
+    if (strlen(link->value.pv_link.pvname) >= sizeof(recordname)) return "";
+    strcpy(recordname, link->value.pv_link.pvname);
+    field = "VAL";
+    if ((p = strchr(recordname, '.')) != NULL)
+    {
+        recordname[p - recordname] = 0;
+        field = p + 1;
+    }
+    if (dbFindRecord(&ctx->target, recordname) != 0) return "";  /* not local */
+    for (p = field; *p; p++)
+        if (!isalnum((unsigned char)*p) && *p != '_') return "field modifier";
+    if (dbFindField(&ctx->target, field) != 0) return "no such field";
+    if (link->value.pv_link.pvlMask & (pvlOptCP|pvlOptCPP)) return
+        link->value.pv_link.pvlMask & pvlOptCP ? "CP" : "CPP";
+
+    precord = ctx->target.precnode->precord;
+    *pp = 0;
+    switch (pdbEntry->pflddes->field_type)
+    {
+        case DBF_OUTLINK:
+            *pp = strcmp(field, "PROC") == 0 ||
+                (ctx->target.pflddes->process_passive && precord->scan == 0);
+            break;
+        case DBF_FWDLINK:
+            if (precord->scan != 0) return "target not passive";
+            *pp = 1;
+            break;
+        default:
+            break;
+    }
+    return NULL;
+}
+
+static void optimizeLink(DBENTRY *pdbEntry, const char *symbol, void *arg)
+{
+    struct optimizeContext *ctx = arg;
+    DBLINK *link = (DBLINK *)pdbEntry->pfield;
+    const char *reason;
+    int pp = 0;
+
+    if (link->type != PV_LINK) return;
+    if (!(link->value.pv_link.pvlMask & (pvlOptCA|pvlOptCP|pvlOptCPP))) return;
+    reason = optimizeCheckTarget(ctx, pdbEntry, &pp);
+    if (reason && !*reason) return;
+
+    ctx->found++;
+    printf("%s.%s %s %s", dbGetRecordName(pdbEntry), dbGetFieldName(pdbEntry),
+        symbol, dbGetString(pdbEntry));
+    if (reason)
+    {
+        ctx->kept++;
+        printf(" (%s, kept as CA)\n", reason);
+        return;
+    }
+    if (ctx->convert)
+    {
+        link->value.pv_link.pvlMask &= ~(pvlOptCA|pvlOptPP);
+        if (pp) link->value.pv_link.pvlMask |= pvlOptPP;
+        ctx->converted++;
+        printf(" -> %s\n", dbGetString(pdbEntry));
+    }
+    else
+        printf("\n");
+}
+
+long optimizeLocalCaLinks(int convert)
+{
+    struct optimizeContext ctx;
+
+    if (!pdbbase)
+    {
+        fprintf(stderr, "optimizeLocalCaLinks: No database loaded\n");
+        return -1;
+    }
+    if (interruptAccept)
+    {
+        fprintf(stderr, "optimizeLocalCaLinks: must be called before iocInit\n");
+        return -1;
+    }
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.convert = convert;
+    dbInitEntry(pdbbase, &ctx.target);
+    dbllForEachLink(DBLL_IMASK|DBLL_OMASK|DBLL_FMASK|DBLL_DMASK, optimizeLink, &ctx);
+    dbFinishEntry(&ctx.target);
+    printf("%d CA links to local records, %d converted to DB links, %d kept as CA\n",
+        ctx.found, ctx.converted, ctx.kept);
+    return 0;
+}
+
+static const iocshFuncDef optimizeLocalCaLinksDef =
+    { "optimizeLocalCaLinks", 1, (const iocshArg *[]) {
+    &(iocshArg) { "convert", iocshArgInt },
+}};
+
+/*
+    optimizeLocalCaLinks: Find CA links to records of this IOC
+
+    To be called before iocInit.
+    Lists all links with CA, CP or CPP flag that point to a record
+    of this IOC. With convert = 1, links with CA flag are turned into
+    database links, so they do not need the CA client library.
+    PP is added to output and forward links where the CA link would have
+    processed the target. CP and CPP links and forward links to records
+    that are not passive are kept as CA.
+    Note that database links, unlike CA links, merge the lock sets of
+    both records.
+*/
+
+void optimizeLocalCaLinksFunc(const iocshArgBuf *args)
+{
+    optimizeLocalCaLinks(args[0].ival);
+}
+
+static void optimizeLocalCaLinksRegistrar(void)
+{
+    iocshRegister(&optimizeLocalCaLinksDef, optimizeLocalCaLinksFunc);
+}
+
+epicsExportRegistrar(optimizeLocalCaLinksRegistrar);
@@ -0,0 +1,459 @@
+/* scanStats.c
+*
+*  wake up jitter, processing time and overruns of the periodic scans
+*
+* Copyright (C) 2026 Dirk Zimoch
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include "dbStaticLib.h"
+#include "dbAccess.h"
+#include "dbCommon.h"
+#include "dbScan.h"
+#include "dbLock.h"
+#include "recSup.h"
+#include <math.h>
+#include "epicsThread.h"
+#include "epicsMutex.h"
+#include "epicsTime.h"
+#include "initHooks.h"
+#include "epicsStdioRedirect.h"
+#include "iocsh.h"
+#include "epicsExport.h"
+
+/*
+    The scan threads have no hooks, thus the process function of all
+    periodic records is wrapped: each record type used by a periodic
+    record gets a copy of its record support table with process
+    replaced, and the records point to that copy. The wrapper takes
+    time stamps only when the record is processed by the scan thread of
+    its own rate (found by name, "scan-<period>" or "scan<period>").
+
+    The records of a scan list are processed in PHAS order, the same
+    order is computed here. A record with a lower or equal position than
+    the previous one starts a new cycle. A cycle lasts from the start of
+    the first processed record to the end of the last one. Jitter is
+    the deviation of the time between two cycle starts from the period
+    (not the lateness against the schedule of the scan thread, which is
+    not known here), an overrun is a cycle taking longer than the period.
+    The cycle state is only used by the scan thread, the statistics are
+    updated once per cycle and read or reset with the lock of the rate.
+    Menu choices with the same period (e.g. "1 second" and "1 Hz") would
+    get scan threads with the same name, these are skipped.
+
+    Records that become periodic after the statistics have been started
+    are not seen. Cycles in which all records are disabled are not seen
+    and make the next cycle look late (jitter of one period).
+*/
+
+#define SCANSTATS_BUCKETS 24        /* bucket i: time < 2^i us */
+
+struct scanStatsHist {
+    unsigned long count;
+    double sum;
+    double max;
+    unsigned long bucket[SCANSTATS_BUCKETS];
+};
+
+struct scanStatsRate {
+    const char *name;               /* menuScan choice */
+    double period;
+    epicsThreadId tid;
+    const char *sameAs;             /* earlier menuScan choice with same period */
+    unsigned long nrecords;
+    /* current cycle */
+    int inCycle;
+    size_t lastIndex;
+    epicsTimeStamp cycleStart, lastEnd;
+    /* statistics, protected by lock */
+    epicsMutexId lock;
+    unsigned long cycles, overruns;
+    struct scanStatsHist jitter, busy;
+    epicsTimeStamp since;
+};
+
+struct scanStatsRecord {
+    struct dbCommon *precord;
+    short scan;
+    size_t index;                   /* position in scan list */
+    size_t seq;                     /* database order */
+};
+
+struct scanStatsRset {
+    struct rset rset;               /* must be first */
+    struct rset *orig;
+    struct scanStatsRset *next;
+};
+
+static struct scanStatsRate *scanStatsRates;
+static int scanStatsNRates;
+static struct scanStatsRecord *scanStatsRecords;
+static size_t scanStatsNRecords;
+static struct scanStatsRset *scanStatsRsets;
+static int scanStatsInstalled;
+static int scanStatsPending;
+
+static void scanStatsAdd(struct scanStatsHist *hist, double us)
+{
+    int i;
+
+    if (us < 0) us = 0;
+    for (i = 0; i < SCANSTATS_BUCKETS-1 && us >= (double)(1ul << i); i++);
+    hist->bucket[i]++;
+    hist->count++;
+    hist->sum += us;
+    if (us > hist->max) hist->max = us;
+}
+
+static double scanStatsPercentile(const struct scanStatsHist *hist, double p)
+{
+    unsigned long n = 0;
+    int i;
+
+    for (i = 0; i < SCANSTATS_BUCKETS-1; i++)
+    {
+        n += hist->bucket[i];
+        if (n >= p * hist->count) break;
+    }
+    return (double)(1ul << i) < hist->max ? (double)(1ul << i) : hist->max;
+}
+
+static int scanStatsRecordCompare(const void *a, const void *b)
+{
+    const struct dbCommon *pa = ((const struct scanStatsRecord *)a)->precord;
+    const struct dbCommon *pb = ((const struct scanStatsRecord *)b)->precord;
+    return pa < pb ? -1 : pa > pb ? 1 : 0;
+}
+
+/* scan list order: by rate, then PHAS, then database order */
+static int scanStatsListCompare(const void *a, const void *b)
+{
+    const struct scanStatsRecord *ra = a, *rb = b;
+
+    if (ra->scan != rb->scan) return ra->scan < rb->scan ? -1 : 1;
+    if (ra->precord->phas != rb->precord->phas)
+        return ra->precord->phas < rb->precord->phas ? -1 : 1;
+    return ra->seq < rb->seq ? -1 : ra->seq > rb->seq;
+}
+
+/* called by the scan thread when a new cycle starts */
+static void scanStatsCycle(struct scanStatsRate *rate, const epicsTimeStamp *now)
+{
+    if (rate->inCycle)
+    {
+        double busy = epicsTimeDiffInSeconds(&rate->lastEnd, &rate->cycleStart);
+        double jitter = fabs(epicsTimeDiffInSeconds(now, &rate->cycleStart) - rate->period);
+
+        epicsMutexMustLock(rate->lock);
+        rate->cycles++;
+        scanStatsAdd(&rate->busy, busy * 1e6);
+        scanStatsAdd(&rate->jitter, jitter * 1e6);
+        if (busy > rate->period) rate->overruns++;
+        epicsMutexUnlock(rate->lock);
+    }
+    rate->cycleStart = *now;
+    rate->inCycle = 1;
+}
+
+static long scanStatsProcess(struct dbCommon *precord)
+{
+    struct scanStatsRset *wrapper = (struct scanStatsRset *)(void *)precord->rset;
+    struct scanStatsRecord key, *r;
+    struct scanStatsRate *rate;
+    epicsTimeStamp now;
+    long status;
+
+    if (precord->scan < SCAN_1ST_PERIODIC || precord->scan >= scanStatsNRates ||
+        scanStatsRates[precord->scan].tid != epicsThreadGetIdSelf())
+        return wrapper->orig->process(precord);
+    key.precord = precord;
+    r = bsearch(&key, scanStatsRecords, scanStatsNRecords,
+        sizeof(struct scanStatsRecord), scanStatsRecordCompare);
+    if (!r || r->scan != precord->scan)
+        return wrapper->orig->process(precord);
+    rate = &scanStatsRates[r->scan];
+    epicsTimeGetCurrent(&now);
+    if (!rate->inCycle || r->index <= rate->lastIndex)
+        scanStatsCycle(rate, &now);
+    status = wrapper->orig->process(precord);
+    epicsTimeGetCurrent(&rate->lastEnd);
+    rate->lastIndex = r->index;
+    return status;
+}
+
+static struct scanStatsRset *scanStatsWrap(struct rset *orig)
+{
+    struct scanStatsRset *wrapper;
+
+    for (wrapper = scanStatsRsets; wrapper; wrapper = wrapper->next)
+        if (wrapper->orig == orig || &wrapper->rset == orig) return wrapper;
+    if (!orig->process) return NULL;
+    wrapper = calloc(1, sizeof(struct scanStatsRset));
+    if (!wrapper) return NULL;
+    wrapper->rset = *orig;
+    wrapper->rset.process = (RECSUPFUN)scanStatsProcess;
+    wrapper->orig = orig;
+    wrapper->next = scanStatsRsets;
+    scanStatsRsets = wrapper;
+    return wrapper;
+}
+
+/* "0.1 second", "10 Hz", "1 minute" */
+static double scanStatsPeriod(const char *choice)
+{
+    char *unit;
+    double value = strtod(choice, &unit);
+
+    while (isspace((unsigned char)*unit)) unit++;
+    if (strncmp(unit, "Hz", 2) == 0) return value > 0 ? 1 / value : 0;
+    if (strncmp(unit, "minute", 6) == 0) return value * 60;
+    if (strncmp(unit, "hour", 4) == 0) return value * 3600;
+    return value;
+}
+
+static long scanStatsInstall(void)
+{
+    dbMenu *menuScan;
+    DBENTRY dbEntry;
+    long status;
+    size_t n = 0, size = 0, i;
+    int j;
+    char threadname[32];
+
+    menuScan = dbFindMenu(pdbbase, "menuScan");
+    if (!menuScan)
+    {
+        fprintf(stderr, "scanStats: no menuScan\n");
+        return -1;
+    }
+    scanStatsRates = calloc(menuScan->nChoice, sizeof(struct scanStatsRate));
+    if (!scanStatsRates)
+    {
+        fprintf(stderr, "scanStats: out of memory\n");
+        return -1;
+    }
+    for (j = SCAN_1ST_PERIODIC; j < menuScan->nChoice; j++)
+    {
+        struct scanStatsRate *rate = &scanStatsRates[j];
+        int k;
+
+        rate->name = menuScan->papChoiceValue[j];
+        rate->period = scanStatsPeriod(rate->name);
+        rate->lock = epicsMutexMustCreate();
+        epicsTimeGetCurrent(&rate->since);
+        for (k = SCAN_1ST_PERIODIC; k < j; k++)
+            if (scanStatsRates[k].period == rate->period) break;
+        if (k < j)
+        {
+            /* which scan thread is which is unknown */
+            rate->sameAs = scanStatsRates[k].name;
+            scanStatsRates[k].sameAs = rate->name;
+            scanStatsRates[k].tid = NULL;
+            continue;
+        }
+        epicsSnprintf(threadname, sizeof(threadname), "scan-%g", rate->period);
+        rate->tid = epicsThreadGetId(threadname);
+        if (!rate->tid)
+        {
+            epicsSnprintf(threadname, sizeof(threadname), "scan%g", rate->period);
+            rate->tid = epicsThreadGetId(threadname);
+        }
+    }
+
+    dbInitEntry(pdbbase, &dbEntry);
+    for (status = dbFirstRecordType(&dbEntry); !status; status = dbNextRecordType(&dbEntry))
+    for (status = dbFirstRecord(&dbEntry); !status; status = dbNextRecord(&dbEntry))
+    {
+        struct dbCommon *precord = dbEntry.precnode->precord;
+
+#ifdef DBRN_FLAGS_ISALIAS
+        if (dbIsAlias(&dbEntry)) continue;
+#endif
+        if (precord->scan < SCAN_1ST_PERIODIC || precord->scan >= menuScan->nChoice) continue;
+        if (!scanStatsRates[precord->scan].tid || !precord->rset) continue;
+        if (!((struct rset *)precord->rset)->process) continue;
+        if (n == size)
+        {
+            struct scanStatsRecord *records;
+
+            size = size ? size * 2 : 256;
+            records = realloc(scanStatsRecords, size * sizeof(struct scanStatsRecord));
+            if (!records)
+            {
+                fprintf(stderr, "scanStats: out of memory\n");
+                dbFinishEntry(&dbEntry);
+                return -1;
+            }
+            scanStatsRecords = records;
+        }
+        scanStatsRecords[n].precord = precord;
+        scanStatsRecords[n].scan = precord->scan;
+        scanStatsRecords[n].seq = n;
+        n++;
+    }
+    dbFinishEntry(&dbEntry);
+
+    qsort(scanStatsRecords, n, sizeof(struct scanStatsRecord), scanStatsListCompare);
+    for (i = 0; i < n; i++)
+        scanStatsRecords[i].index = scanStatsRates[scanStatsRecords[i].scan].nrecords++;
+    qsort(scanStatsRecords, n, sizeof(struct scanStatsRecord), scanStatsRecordCompare);
+    scanStatsNRecords = n;
+    scanStatsNRates = menuScan->nChoice;
+
+    /* the lookup table is complete, now let the records use it */
+    for (i = 0; i < n; i++)
+    {
+        struct dbCommon *precord = scanStatsRecords[i].precord;
+        struct scanStatsRset *wrapper;
+
+        dbScanLock(precord);
+        wrapper = scanStatsWrap((struct rset *)(void *)precord->rset);
+        if (wrapper) precord->rset = (void *)&wrapper->rset;
+        dbScanUnlock(precord);
+    }
+    scanStatsInstalled = 1;
+    return 0;
+}
+
+static void scanStatsInitHook(initHookState state)
+{
+    if (state != initHookAfterIocRunning || !scanStatsPending) return;
+    if (scanStatsInstall() == 0)
+        printf("scanStats: collecting statistics of %lu periodic records\n",
+            (unsigned long)scanStatsNRecords);
+}
+
+static void scanStatsPrintHist(const char *title, const struct scanStatsHist *hist)
+{
+    int i;
+
+    printf("    %s:", title);
+    for (i = 0; i < SCANSTATS_BUCKETS; i++)
+    {
+        if (!hist->bucket[i]) continue;
+        printf(" <%luus:%lu", 1ul << i, hist->bucket[i]);
+    }
+    printf("\n");
+}
+
+long scanStats(int level, int reset)
+{
+    epicsTimeStamp now;
+    int j;
+
+    if (!interruptAccept)
+    {
+        scanStatsPending = 1;
+        printf("scanStats: statistics will be collected after iocInit\n");
+        return 0;
+    }
+    if (!scanStatsInstalled)
+    {
+        if (scanStatsInstall() != 0) return -1;
+        printf("scanStats: collecting statistics of %lu periodic records\n",
+            (unsigned long)scanStatsNRecords);
+        return 0;
+    }
+    printf("%-14s %7s %9s %8s %9s %9s %9s %9s %9s %9s %9s %9s\n",
+        "scan", "records", "cycles", "overruns", "jitter/us", "p50", "p99", "max",
+        "busy/us", "p50", "p99", "max");
+    for (j = SCAN_1ST_PERIODIC; j < scanStatsNRates; j++)
+    {
+        struct scanStatsRate *rate = &scanStatsRates[j];
+        struct scanStatsHist jitter, busy;
+        unsigned long cycles, overruns;
+        epicsTimeStamp since;
+        double n;
+
+        if (rate->sameAs)
+        {
+            if (level > 0) printf("%-14s same period as %s, not measured\n", rate->name, rate->sameAs);
+            continue;
+        }
+        if (!rate->tid)
+        {
+            if (level > 0) printf("%-14s no scan thread found\n", rate->name);
+            continue;
+        }
+        if (!rate->nrecords && level < 1) continue;
+        epicsMutexMustLock(rate->lock);
+        epicsTimeGetCurrent(&now);
+        cycles = rate->cycles;
+        overruns = rate->overruns;
+        jitter = rate->jitter;
+        busy = rate->busy;
+        since = rate->since;
+        if (reset)
+        {
+            rate->cycles = rate->overruns = 0;
+            memset(&rate->jitter, 0, sizeof(rate->jitter));
+            memset(&rate->busy, 0, sizeof(rate->busy));
+            rate->since = now;
+        }
+        epicsMutexUnlock(rate->lock);
+        n = cycles ? (double)cycles : 1;
+        printf("%-14s %7lu %9lu %8lu %9.0f %9.0f %9.0f %9.0f %9.0f %9.0f %9.0f %9.0f\n",
+            rate->name, rate->nrecords, cycles, overruns,
+            jitter.sum / n, scanStatsPercentile(&jitter, 0.5),
+            scanStatsPercentile(&jitter, 0.99), jitter.max,
+            busy.sum / n, scanStatsPercentile(&busy, 0.5),
+            scanStatsPercentile(&busy, 0.99), busy.max);
+        if (level > 0 && cycles)
+        {
+            printf("    %.1f Hz measured over %.1f s\n",
+                cycles / epicsTimeDiffInSeconds(&now, &since),
+                epicsTimeDiffInSeconds(&now, &since));
+            scanStatsPrintHist("jitter", &jitter);
+            scanStatsPrintHist("busy", &busy);
+        }
+    }
+    return 0;
+}
+
+static const iocshFuncDef scanStatsDef =
+    { "scanStats", 2, (const iocshArg *[]) {
+    &(iocshArg) { "level", iocshArgInt },
+    &(iocshArg) { "reset", iocshArgInt },
+}};
+
+/*
+    scanStats: Timing statistics of the periodic scans
+
+    The first call starts collecting (or schedules it for iocInit when
+    called before). Later calls show for each scan rate the number of
+    cycles, overruns (cycles taking longer than the period) and mean,
+    50% and 99% percentiles (from log2 histograms) and maximum of the
+    jitter (deviation of the time between cycle starts from the period)
+    and of the processing time in microseconds. Menu choices with the
+    same period as an earlier one are not measured.
+    Level 1 adds the measured rate, the histograms and empty rates.
+    With reset = 1 the statistics restart after printing.
+*/
+
+void scanStatsFunc(const iocshArgBuf *args)
+{
+    scanStats(args[0].ival, args[1].ival);
+}
+
+static void scanStatsRegistrar(void)
+{
+    iocshRegister(&scanStatsDef, scanStatsFunc);
+    initHookRegister(scanStatsInitHook);
+}
+
+epicsExportRegistrar(scanStatsRegistrar);
@@ -31,6 +31,8 @@
 #include "errlog.h"
 #include "epicsExport.h"
 
+#include "threads.h"
+
 #ifndef CPU_SETSIZE
 typedef unsigned int cpu_set_t;
 #define CPU_SETSIZE (8*sizeof(cpu_set_t))
@@ -84,7 +86,7 @@ static epicsThreadId epicsThreadGetIdFromNameOrNumber(const char* threadname)
     return id;
 }
 
-static int epicsThreadStrToPrio(const char* priostr, int diff)
+int threadsStrToPrio(const char* priostr, int diff)
 {
     int priority;
     char* end;
@@ -159,7 +161,7 @@ static void epicsThreadSetPriorityFunc(const iocshArgBuf *args)
     }
     id = epicsThreadGetIdFromNameOrNumber(threadname);
     if (!id) return;
-    priority = epicsThreadStrToPrio(priostr, diff);
+    priority = threadsStrToPrio(priostr, diff);
     if (priority < 0) return;
     errVerbose = 1;
     epicsThreadSetPriority(id, priority);
@@ -295,6 +297,17 @@ int epicsThreadSetAffinity(epicsThreadId id, cpu_set_t* cpuset)
     return status;
 }
 
+int threadsSetAffinityList(epicsThreadId id, const char* cpulist)
+{
+    cpu_set_t cpuset;
+    int status;
+
+    status = epicsThreadGetAffinity(id, &cpuset);
+    if (status != 0) return status;
+    epicsThreadParseAffinityList(cpulist, &cpuset);
+    return epicsThreadSetAffinity(id, &cpuset);
+}
+
 static const iocshArg epicsThreadSetAffinityArg0 = { "thread", iocshArgString };
 static const iocshArg epicsThreadSetAffinityArg1 = { "cpulist", iocshArgString };
 static const iocshArg * const epicsThreadSetAffinityArgs[2] = { &epicsThreadSetAffinityArg0, &epicsThreadSetAffinityArg1};
@@ -313,9 +326,7 @@ static void epicsThreadSetAffinityFunc(const iocshArgBuf *args)
         return;
     }
     id = epicsThreadGetIdFromNameOrNumber(threadname);
-    if (epicsThreadGetAffinity(id, &cpuset) != 0) return;
-    epicsThreadParseAffinityList(cpulist, &cpuset);
-    if (epicsThreadSetAffinity(id, &cpuset) != 0) return;
+    if (threadsSetAffinityList(id, cpulist) != 0) return;
     if (epicsThreadGetAffinity(id, &cpuset) != 0) return;
     epicsThreadPrintAffinityList(&cpuset);
 }
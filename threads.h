@@ -0,0 +1,23 @@
+#ifndef threads_h
+#define threads_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "epicsThread.h"
+
+/* Priority from a number, a name like "CAServerLow" or the name of
+   another thread, moved diff levels up or down. Returns -1 on error. */
+int threadsStrToPrio(const char* priostr, int diff);
+
+/* Change the affinity of a thread (NULL: this thread) with a cpu list
+   like "0,2-3". With + or - in front, cpus are added to or removed
+   from the current affinity. Returns 0 on success. */
+int threadsSetAffinityList(epicsThreadId id, const char* cpulist);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif